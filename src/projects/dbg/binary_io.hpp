@@ -0,0 +1,59 @@
+#pragma once
+
+#include "sequences/sequence.hpp"
+#include "common/verify.hpp"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//Helpers for binary serialization of graph and alignment state. Values are written in native byte order,
+//so files are only meant to be read on the machine that produced them.
+namespace binary_io {
+    template<class T>
+    inline void Write(std::ostream &os, const T &value) {
+        os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<class T>
+    inline T Read(std::istream &is) {
+        T value{};
+        is.read(reinterpret_cast<char *>(&value), sizeof(T));
+        VERIFY_MSG(is.good(), "Unexpected end of binary file");
+        return value;
+    }
+
+    inline void WriteString(std::ostream &os, const std::string &s) {
+        Write<uint64_t>(os, s.size());
+        os.write(s.data(), s.size());
+    }
+
+    inline std::string ReadString(std::istream &is) {
+        std::string s(Read<uint64_t>(is), '\0');
+        is.read(&s[0], s.size());
+        VERIFY_MSG(is.good(), "Unexpected end of binary file");
+        return s;
+    }
+
+    //Nucleotides are packed four per byte
+    inline void WriteSequence(std::ostream &os, const Sequence &seq) {
+        Write<uint64_t>(os, seq.size());
+        std::vector<unsigned char> packed((seq.size() + 3) / 4, 0);
+        for(size_t i = 0; i < seq.size(); i++) {
+            packed[i >> 2u] |= seq[i] << ((i & 3u) << 1u);
+        }
+        os.write(reinterpret_cast<const char *>(packed.data()), packed.size());
+    }
+
+    inline Sequence ReadSequence(std::istream &is) {
+        size_t size = Read<uint64_t>(is);
+        std::vector<unsigned char> packed((size + 3) / 4);
+        is.read(reinterpret_cast<char *>(packed.data()), packed.size());
+        VERIFY_MSG(is.good(), "Unexpected end of binary file");
+        std::vector<unsigned char> nucls(size);
+        for(size_t i = 0; i < size; i++) {
+            nucls[i] = (packed[i >> 2u] >> ((i & 3u) << 1u)) & 3u;
+        }
+        return Sequence(nucls);
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "common/hash_utils.hpp"
+#include "common/verify.hpp"
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <experimental/filesystem>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * Binary storage of sorted vertex hashes.
+ * File layout:
+ *   Header
+ *   uint64_t[block_count + 1]               offsets of blocks counted from the end of this array
+ *   blocks                                  first hash of the block as is followed by differences between
+ *                                           consecutive hashes in LEB128 encoding
+ * Every block except the last one contains exactly block_size hashes, so blocks are encoded and decoded by
+ * different threads independently. The file is loaded with mmap.
+ */
+namespace binary_vertices {
+    const char MAGIC[8] = {'L', 'J', 'A', 'V', 'T', 'X', '0', '1'};
+
+    struct Header {
+        char magic[8];
+        uint64_t count;
+        uint64_t block_size;
+        uint64_t block_count;
+    };
+
+    inline void WriteAt(int fd, const char *data, size_t size, size_t offset) {
+        while(size > 0) {
+            ssize_t written = pwrite(fd, data, size, offset);
+            VERIFY_MSG(written > 0, "Failed to write vertex hashes");
+            data += written;
+            size -= written;
+            offset += written;
+        }
+    }
+
+    inline bool IsBinary(const std::experimental::filesystem::path &fname) {
+        char magic[sizeof(MAGIC)];
+        int fd = open(fname.c_str(), O_RDONLY);
+        VERIFY_MSG(fd >= 0, "Could not open vertex file " + fname.string());
+        bool res = read(fd, magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+        close(fd);
+        return res;
+    }
+
+    //Hashes should be sorted and should not repeat
+    inline void Write(const std::experimental::filesystem::path &fname, const std::vector<hashing::htype> &hashes,
+                      size_t threads, size_t block_size = 1 << 16) {
+        VERIFY(std::adjacent_find(hashes.begin(), hashes.end(), std::greater_equal<hashing::htype>()) == hashes.end());
+        size_t block_count = (hashes.size() + block_size - 1) / block_size;
+        std::vector<std::string> blocks(block_count);
+        omp_set_num_threads(threads);
+#pragma omp parallel for default(none) shared(hashes, blocks, block_count, block_size) schedule(dynamic, 1)
+        for(size_t i = 0; i < block_count; i++) {
+            std::string &block = blocks[i];
+            size_t left = i * block_size;
+            size_t right = std::min(hashes.size(), left + block_size);
+            block.append(reinterpret_cast<const char *>(&hashes[left]), sizeof(hashing::htype));
+            for(size_t j = left + 1; j < right; j++) {
+                hashing::htype delta = hashes[j] - hashes[j - 1];
+                while(delta >= 128) {
+                    block.push_back(char((delta & 127u) | 128u));
+                    delta >>= 7u;
+                }
+                block.push_back(char(delta));
+            }
+        }
+        std::vector<uint64_t> offsets(block_count + 1, 0);
+        for(size_t i = 0; i < block_count; i++) {
+            offsets[i + 1] = offsets[i] + blocks[i].size();
+        }
+        int fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        VERIFY_MSG(fd >= 0, "Could not open file " + fname.string() + " for writing");
+        Header header{};
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.count = hashes.size();
+        header.block_size = block_size;
+        header.block_count = block_count;
+        WriteAt(fd, reinterpret_cast<const char *>(&header), sizeof(Header), 0);
+        WriteAt(fd, reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t), sizeof(Header));
+        size_t data_offset = sizeof(Header) + offsets.size() * sizeof(uint64_t);
+#pragma omp parallel for default(none) shared(fd, blocks, offsets, block_count, data_offset) schedule(dynamic, 1)
+        for(size_t i = 0; i < block_count; i++) {
+            WriteAt(fd, blocks[i].data(), blocks[i].size(), data_offset + offsets[i]);
+        }
+        close(fd);
+    }
+
+    inline std::vector<hashing::htype> Read(const std::experimental::filesystem::path &fname, size_t threads) {
+        int fd = open(fname.c_str(), O_RDONLY);
+        VERIFY_MSG(fd >= 0, "Could not open vertex file " + fname.string());
+        struct stat st{};
+        fstat(fd, &st);
+        size_t file_size = st.st_size;
+        VERIFY_MSG(file_size >= sizeof(Header), "Vertex file " + fname.string() + " is truncated");
+        void *addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        VERIFY_MSG(addr != MAP_FAILED, "Could not map vertex file " + fname.string());
+        const char *data = static_cast<const char *>(addr);
+        Header header{};
+        memcpy(&header, data, sizeof(Header));
+        VERIFY_MSG(memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0,
+                   "File " + fname.string() + " is not an LJA binary vertex file");
+        std::string truncated = "Vertex file " + fname.string() + " is truncated";
+        VERIFY_MSG(header.block_size > 0 && header.block_count == (header.count + header.block_size - 1) / header.block_size,
+                   "Vertex file " + fname.string() + " has inconsistent header");
+        //Offsets table is checked to fit into the file before the end of the last block is read from it
+        VERIFY_MSG(header.block_count < (file_size - sizeof(Header)) / sizeof(uint64_t), truncated);
+        const uint64_t *offsets = reinterpret_cast<const uint64_t *>(data + sizeof(Header));
+        const char *blocks = reinterpret_cast<const char *>(offsets + header.block_count + 1);
+        VERIFY_MSG(offsets[header.block_count] <= size_t(data + file_size - blocks), truncated);
+        for(size_t i = 0; i < header.block_count; i++) {
+            VERIFY_MSG(offsets[i] <= offsets[i + 1] && offsets[i + 1] - offsets[i] >= sizeof(hashing::htype), truncated);
+        }
+        std::vector<hashing::htype> res(header.count);
+        omp_set_num_threads(threads);
+#pragma omp parallel for default(none) shared(header, offsets, blocks, res) schedule(dynamic, 1)
+        for(size_t i = 0; i < header.block_count; i++) {
+            const char *pos = blocks + offsets[i];
+            size_t left = i * header.block_size;
+            size_t right = std::min<size_t>(header.count, left + header.block_size);
+            hashing::htype cur;
+            memcpy(&cur, pos, sizeof(hashing::htype));
+            pos += sizeof(hashing::htype);
+            res[left] = cur;
+            for(size_t j = left + 1; j < right; j++) {
+                hashing::htype delta = 0;
+                size_t shift = 0;
+                while(true) {
+                    unsigned char c = *pos;
+                    pos++;
+                    delta |= hashing::htype(c & 127u) << shift;
+                    if(c < 128)
+                        break;
+                    shift += 7;
+                }
+                cur += delta;
+                res[j] = cur;
+            }
+        }
+        munmap(addr, file_size);
+        close(fd);
+        return std::move(res);
+    }
+}
@@ -0,0 +1,86 @@
+#include "checkpoints.hpp"
+#include "binary_io.hpp"
+#include <common/dir_utils.hpp>
+
+namespace {
+    const char MAGIC[8] = {'L', 'J', 'A', 'C', 'K', 'P', '0', '1'};
+}
+
+StageCheckpoints::StageCheckpoints(logging::Logger &logger, size_t threads, const std::experimental::filesystem::path &dir,
+                                   bool save, bool resume) : logger(logger), threads(threads), file(dir / "state.bin"),
+                                   save(save) {
+    if(!resume || !std::experimental::filesystem::is_regular_file(file)) {
+        if(save) {
+            ensure_dir_existance(dir);
+            std::experimental::filesystem::remove(file);
+        }
+        return;
+    }
+    is.open(file, std::ios::binary);
+    char magic[8];
+    is.read(magic, sizeof(magic));
+    VERIFY_MSG(is.good() && std::equal(magic, magic + sizeof(magic), MAGIC), "File " + file.string() + " is not an LJA checkpoint");
+    completed.resize(binary_io::Read<uint64_t>(is));
+    for(std::string &name : completed)
+        name = binary_io::ReadString(is);
+    if(completed.empty()) {
+        is.close();
+        return;
+    }
+    logger.info() << "Resuming from checkpoint made after substep " << completed.back() << std::endl;
+}
+
+dbg::SparseDBG StageCheckpoints::loadGraph(const hashing::RollingHash &hasher) {
+    VERIFY(resuming());
+    logger.info() << "Loading graph from checkpoint " << file << std::endl;
+    dbg::SparseDBG res = dbg::SparseDBG::loadBinary(is, hasher);
+    logger.info() << "Loaded graph with " << res.size() << " vertices" << std::endl;
+    return std::move(res);
+}
+
+void StageCheckpoints::track(dbg::SparseDBG &graph, const std::vector<RecordStorage *> &stage_storages) {
+    dbg = &graph;
+    storages = stage_storages;
+    if(!resuming())
+        return;
+    VERIFY_MSG(binary_io::Read<uint64_t>(is) == storages.size(), "Checkpoint " + file.string() + " has different read storages");
+    logger.info() << "Loading read alignments from checkpoint" << std::endl;
+    for(RecordStorage *storage : storages) {
+        storage->LoadBinary(logger, threads, is, graph);
+    }
+    is.close();
+}
+
+void StageCheckpoints::run(const std::string &name, const std::function<void()> &task) {
+    if(step_num < completed.size()) {
+        VERIFY_MSG(completed[step_num] == name, "Checkpoint " + file.string() + " was made by a different pipeline");
+        logger.info() << "Skipping " << name << " since it was completed before restart" << std::endl;
+        step_num++;
+        return;
+    }
+    task();
+    step_num++;
+    completed.emplace_back(name);
+    if(save)
+        saveState();
+}
+
+void StageCheckpoints::saveState() {
+    VERIFY(dbg != nullptr);
+    logger.info() << "Saving checkpoint after " << completed.back() << " to " << file << std::endl;
+    std::experimental::filesystem::path tmp = file.string() + ".tmp";
+    std::ofstream os;
+    os.open(tmp, std::ios::binary);
+    os.write(MAGIC, sizeof(MAGIC));
+    binary_io::Write<uint64_t>(os, completed.size());
+    for(const std::string &name : completed)
+        binary_io::WriteString(os, name);
+    dbg->saveBinary(os);
+    binary_io::Write<uint64_t>(os, storages.size());
+    for(RecordStorage *storage : storages)
+        storage->SaveBinary(os);
+    os.close();
+    VERIFY_MSG(!os.fail(), "Failed to write checkpoint " + tmp.string());
+//    Rename replaces the previous checkpoint atomically so that an interrupted save leaves a usable checkpoint
+    std::experimental::filesystem::rename(tmp, file);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "graph_alignment_storage.hpp"
+#include "sparse_dbg.hpp"
+#include <common/logging.hpp>
+#include <experimental/filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Checkpoints between substeps of a stage. After every completed substep the graph, all read storages of the stage
+ * and the list of completed substeps are saved in binary form into a single file that replaces the previous one.
+ * When a stage is resumed, the graph and read storages are loaded from this file and completed substeps are skipped.
+ */
+class StageCheckpoints {
+private:
+    logging::Logger &logger;
+    size_t threads;
+    std::experimental::filesystem::path file;
+    bool save;
+    std::vector<std::string> completed;
+    size_t step_num = 0;
+    std::ifstream is;
+    dbg::SparseDBG *dbg = nullptr;
+    std::vector<RecordStorage *> storages;
+
+    void saveState();
+public:
+    StageCheckpoints(logging::Logger &logger, size_t threads, const std::experimental::filesystem::path &dir,
+                     bool save, bool resume);
+
+    bool resuming() const {return !completed.empty();}
+
+    //Graph as it was after the last completed substep. Should be called only when resuming.
+    dbg::SparseDBG loadGraph(const hashing::RollingHash &hasher);
+    //Storages are filled from the checkpoint when resuming. Graph and storages are saved after every substep.
+    void track(dbg::SparseDBG &graph, const std::vector<RecordStorage *> &stage_storages);
+    //Substeps should be run in the same order every time the stage is run.
+    void run(const std::string &name, const std::function<void()> &task);
+};
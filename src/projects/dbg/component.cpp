@@ -1,4 +1,101 @@
 #include "component.hpp"
+#include <parallel/algorithm>
+
+namespace {
+    size_t FindRoot(std::vector<std::atomic<size_t>> &parent, size_t x) {
+        size_t p = parent[x].load();
+        while(p != x) {
+            size_t gp = parent[p].load();
+            if(gp != p)
+                parent[x].compare_exchange_weak(p, gp);
+            x = gp;
+            p = parent[x].load();
+        }
+        return x;
+    }
+
+//    Root with larger number is attached to the root with smaller one, so the root is always the minimal element
+    void Unite(std::vector<std::atomic<size_t>> &parent, size_t a, size_t b) {
+        while(true) {
+            a = FindRoot(parent, a);
+            b = FindRoot(parent, b);
+            if(a == b)
+                return;
+            if(a < b)
+                std::swap(a, b);
+            size_t expected = a;
+            if(parent[a].compare_exchange_strong(expected, b))
+                return;
+        }
+    }
+}
+
+dbg::ComponentLabeling::ComponentLabeling(const dbg::Component &component, size_t threads,
+                                          const std::function<bool(const Edge &)> &splitEdge) : base(component) {
+    size_t n = base.size();
+    _vertices.resize(n);
+    std::vector<std::atomic<size_t>> parent(n);
+#pragma omp parallel for default(none) schedule(static) shared(n, parent) num_threads(threads)
+    for(size_t i = 0; i < n; i++) {
+        _vertices[i] = &graph().getVertex(base.begin()[i]);
+        parent[i].store(i);
+    }
+#pragma omp parallel for default(none) schedule(dynamic, 1024) shared(n, parent, splitEdge) num_threads(threads)
+    for(size_t i = 0; i < n; i++) {
+        for(Vertex *vert : {_vertices[i], &_vertices[i]->rc()}) {
+            for(Edge &edge : *vert) {
+                if(splitEdge(edge))
+                    continue;
+                size_t end = index(*edge.end());
+                if(end != size_t(-1))
+                    Unite(parent, i, end);
+            }
+        }
+    }
+    labels.resize(n);
+#pragma omp parallel for default(none) schedule(static) shared(n, parent) num_threads(threads)
+    for(size_t i = 0; i < n; i++) {
+        labels[i] = FindRoot(parent, i);
+    }
+    parent = std::vector<std::atomic<size_t>>();
+//    Roots precede all other vertices of their components so a single pass renumbers them densely
+    offsets = {0};
+    for(size_t i = 0; i < n; i++) {
+        if(labels[i] == i) {
+            labels[i] = offsets.size() - 1;
+            offsets.emplace_back(0);
+        } else {
+            labels[i] = labels[labels[i]];
+        }
+        offsets[labels[i] + 1]++;
+    }
+    for(size_t i = 1; i < offsets.size(); i++)
+        offsets[i] += offsets[i - 1];
+    grouped.resize(n);
+    std::vector<hashing::htype> hashes(n);
+    std::vector<size_t> pos(offsets.begin(), offsets.end() - 1);
+    for(size_t i = 0; i < n; i++) {
+        grouped[pos[labels[i]]] = _vertices[i];
+        hashes[pos[labels[i]]] = base.begin()[i];
+        pos[labels[i]]++;
+    }
+    grouped_hashes = std::make_shared<const std::vector<hashing::htype>>(std::move(hashes));
+}
+
+size_t dbg::ComponentLabeling::index(const dbg::Vertex &vert) const {
+    auto it = std::lower_bound(base.begin(), base.end(), vert.hash());
+    if(it == base.end() || *it != vert.hash())
+        return size_t(-1);
+    return it - base.begin();
+}
+
+std::vector<dbg::Component> dbg::ComponentLabeling::components() const {
+    std::vector<Component> res;
+    res.reserve(size());
+    for(size_t comp = 0; comp < size(); comp++)
+        res.emplace_back(component(comp));
+    return std::move(res);
+}
 
 std::vector<dbg::Vertex *> dbg::Component::borderVertices() const {
     std::vector<dbg::Vertex *> res;
@@ -34,7 +131,7 @@ size_t dbg::Component::countTips() const {
 
 size_t dbg::Component::isAcyclic() const {
     std::unordered_set<Vertex *> visited;
-    for(hashing::htype hash : v) {
+    for(hashing::htype hash : *this) {
         Vertex & compStart = graph().getVertex(hash);
         for(Vertex *vit : {&compStart, &compStart.rc()}) {
             if(visited.find(vit) != visited.end())
@@ -62,13 +159,13 @@ size_t dbg::Component::isAcyclic() const {
             }
         }
     }
-    return visited.size() == v.size() * 2;
+    return visited.size() == size() * 2;
 }
 
 size_t dbg::Component::realCC() const {
     std::unordered_set<Vertex *> visited;
     size_t cnt = 0;
-    for(hashing::htype hash : v) {
+    for(hashing::htype hash : *this) {
         Vertex & compStart = graph().getVertex(hash);
         for(Vertex *vit : {&compStart, &compStart.rc()}) {
             if(visited.find(vit) != visited.end())
@@ -105,9 +202,9 @@ IterableStorage<ApplyingIterator<dbg::Component::iterator, dbg::Vertex, 2>> dbg:
         else
             return graph().getVertices(hash);
     };
-    ApplyingIterator<iterator, Vertex, 2> begin(v.begin(), v.end(), apply);
-    ApplyingIterator<iterator, Vertex, 2> end(v.end(), v.end(), apply);
-    return {begin, end};
+    ApplyingIterator<iterator, Vertex, 2> vbegin(begin(), end(), apply);
+    ApplyingIterator<iterator, Vertex, 2> vend(end(), end(), apply);
+    return {vbegin, vend};
 }
 
 IterableStorage<ApplyingIterator<dbg::Component::iterator, dbg::Vertex, 2>> dbg::Component::verticesUnique(bool unique) const {
@@ -135,9 +232,9 @@ IterableStorage<ApplyingIterator<dbg::Component::iterator, dbg::Edge, 16>> dbg::
         }
         return res;
     };
-    ApplyingIterator<iterator, Edge, 16> begin(v.begin(), v.end(), apply);
-    ApplyingIterator<iterator, Edge, 16> end(v.end(), v.end(), apply);
-    return {begin, end};
+    ApplyingIterator<iterator, Edge, 16> ebegin(begin(), end(), apply);
+    ApplyingIterator<iterator, Edge, 16> eend(end(), end(), apply);
+    return {ebegin, eend};
 }
 
 IterableStorage<ApplyingIterator<dbg::Component::iterator, dbg::Edge, 16>> dbg::Component::edgesInner() const {
@@ -164,9 +261,13 @@ bool dbg::Component::covers(const dbg::Vertex &vert) const {
     return true;
 }
 
-dbg::Component::Component(dbg::SparseDBG &_graph) : _graph(&_graph) {
+dbg::Component::Component(dbg::SparseDBG &_graph) : _graph(&_graph), left(0), right(_graph.size()) {
+    std::vector<hashing::htype> v;
+    v.reserve(_graph.size());
     for (auto &vert : graph())
-        v.emplace(vert.second.hash());
+        v.emplace_back(vert.second.hash());
+    __gnu_parallel::sort(v.begin(), v.end());
+    storage = std::make_shared<const std::vector<hashing::htype>>(std::move(v));
 }
 
 dbg::Component dbg::Component::neighbourhood(dbg::SparseDBG &graph, Contig &contig, size_t radius) {
@@ -230,34 +331,10 @@ dbg::Component dbg::Component::longEdgeNeighbourhood(dbg::SparseDBG &graph, Cont
 }
 
 std::vector<dbg::Component> dbg::ConditionSplitter::split(const dbg::Component &comp) const {
-    SparseDBG &dbg = comp.graph();
-    std::vector<Component> res;
-    std::unordered_set<hashing::htype, hashing::alt_hasher<hashing::htype>> visited;
+    std::vector<Component> res = ComponentLabeling(comp, threads, splitEdge).components();
     size_t size = 0;
-    for (Vertex &v : comp.verticesUnique()) {
-        std::vector<hashing::htype> queue;
-        if (visited.find(v.hash()) != visited.end())
-            continue;
-        queue.push_back(v.hash());
-        std::vector<hashing::htype> component;
-        while (!queue.empty()) {
-            hashing::htype val = queue.back();
-            queue.pop_back();
-            if (visited.find(val) != visited.end())
-                continue;
-            visited.insert(val);
-            component.emplace_back(val);
-            for(Vertex *vert : dbg.getVertices(val)) {
-                for (Edge &edge : *vert) {
-                    if (!splitEdge(edge) && comp.contains(*edge.end())) {
-                        queue.emplace_back(edge.end()->hash());
-                    }
-                }
-            }
-        }
-        res.emplace_back(dbg, component.begin(), component.end());
-        size += res.back().size();
-    }
+    for(const Component &component : res)
+        size += component.size();
     VERIFY(size == comp.size());
     return std::move(res);
 }
@@ -3,16 +3,31 @@
 #include "paths.hpp"
 #include "sparse_dbg.hpp"
 #include "common/iterator_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <utility>
 
 namespace dbg {
+    //Set of vertices of the graph given by their canonical hashes. Hashes are stored in a sorted range of a vector
+    //that can be shared between many components, e.g. all components produced by a single split of the graph.
     class Component {
     private:
         SparseDBG *_graph;
-        std::unordered_set<hashing::htype, hashing::alt_hasher<hashing::htype>> v;
+        std::shared_ptr<const std::vector<hashing::htype>> storage;
+        size_t left;
+        size_t right;
     public:
         template<class I>
-        Component(SparseDBG &_graph, I begin, I end) : _graph(&_graph), v(begin, end) {}
+        Component(SparseDBG &_graph, I begin, I end) : _graph(&_graph), left(0) {
+            std::vector<hashing::htype> v(begin, end);
+            std::sort(v.begin(), v.end());
+            v.erase(std::unique(v.begin(), v.end()), v.end());
+            right = v.size();
+            storage = std::make_shared<const std::vector<hashing::htype>>(std::move(v));
+        }
+        Component(SparseDBG &_graph, std::shared_ptr<const std::vector<hashing::htype>> storage, size_t left, size_t right) :
+                _graph(&_graph), storage(std::move(storage)), left(left), right(right) {}
         explicit Component(SparseDBG &_graph);
         template<class I>
         static Component neighbourhood(SparseDBG &graph, I begin, I end, size_t radius, size_t min_coverage = 0);
@@ -20,11 +35,13 @@ namespace dbg {
         static Component longEdgeNeighbourhood(SparseDBG &graph, Contig &contig, size_t long_edge_threshold);
 
         SparseDBG &graph() const {return *_graph;}
-        bool contains(const Vertex &vert) const {return v.find(vert.hash()) != v.end();}
+        bool contains(const Vertex &vert) const {return std::binary_search(begin(), end(), vert.hash());}
         bool covers(const Vertex &vert) const;
-        size_t size() const {return v.size();}
+        size_t size() const {return right - left;}
 
-        typedef std::unordered_set<hashing::htype, hashing::alt_hasher<hashing::htype>>::const_iterator iterator;
+        typedef std::vector<hashing::htype>::const_iterator iterator;
+        iterator begin() const {return storage->begin() + left;}
+        iterator end() const {return storage->begin() + right;}
         IterableStorage<ApplyingIterator<iterator, Vertex, 2>> vertices(bool unique = false) const;
         IterableStorage<ApplyingIterator<iterator, Vertex, 2>> verticesUnique(bool unique = false) const;
         IterableStorage<ApplyingIterator<iterator, Edge, 16>> edges(bool inner = false, bool unique = false) const;
@@ -39,17 +56,56 @@ namespace dbg {
         size_t realCC() const;
     };
 
+    //Connected components of a component of the graph after removal of edges that satisfy splitEdge.
+    //Vertices are numbered in the order of their hashes, so the number of a vertex is found by binary search.
+    //Components are computed by lock-free union-find over vertex numbers, so all edges are processed in parallel.
+    //Component ids are ordered by the smallest hash of a vertex in the component. Hashes of vertices grouped by component
+    //are kept in a single vector and resulting components are views into it.
+    class ComponentLabeling {
+    private:
+        Component base;
+        std::vector<Vertex *> _vertices;
+        std::vector<size_t> labels;
+//        Vertices of component c are grouped[offsets[c]..offsets[c + 1]) in the order of their numbers
+        std::vector<size_t> offsets;
+        std::vector<Vertex *> grouped;
+        std::shared_ptr<const std::vector<hashing::htype>> grouped_hashes;
+    public:
+        ComponentLabeling(const Component &component, size_t threads,
+                          const std::function<bool(const Edge &)> &splitEdge = [](const Edge &){return false;});
+        ComponentLabeling(SparseDBG &graph, size_t threads,
+                          const std::function<bool(const Edge &)> &splitEdge = [](const Edge &){return false;}) :
+                ComponentLabeling(Component(graph), threads, splitEdge) {}
+
+        SparseDBG &graph() const {return base.graph();}
+        size_t size() const {return offsets.size() - 1;}
+//        Returns -1 if the vertex does not belong to the labeled component
+        size_t index(const Vertex &vert) const;
+        size_t label(const Vertex &vert) const {return labels[index(vert)];}
+        size_t componentSize(size_t comp) const {return offsets[comp + 1] - offsets[comp];}
+        IterableStorage<std::vector<Vertex *>::const_iterator> componentVertices(size_t comp) const {
+            return {grouped.begin() + offsets[comp], grouped.begin() + offsets[comp + 1]};
+        }
+        Component component(size_t comp) const {
+            return {graph(), grouped_hashes, offsets[comp], offsets[comp + 1]};
+        }
+        std::vector<Component> components() const;
+    };
+
     class AbstractSplitter {
     public:
         virtual std::vector<Component> split(const Component &component) const = 0;
         std::vector<Component> splitGraph(SparseDBG &dbg) const {return split(Component(dbg));}
     };
 
+    //Splits components by edges that satisfy the condition using ComponentLabeling with the given number of threads
     class ConditionSplitter : public AbstractSplitter {
     private:
         std::function<bool(const Edge &)> splitEdge;
+        size_t threads;
     public:
-        explicit ConditionSplitter(std::function<bool(const Edge &)> splitEdge) : splitEdge(std::move(splitEdge)) {}
+        explicit ConditionSplitter(std::function<bool(const Edge &)> splitEdge, size_t threads = 1) :
+                    splitEdge(std::move(splitEdge)), threads(threads) {}
         std::vector<Component> split(const Component &comp) const override;
     };
 
@@ -57,13 +113,13 @@ namespace dbg {
     private:
         std::function<bool(const Edge &)> splitEdge;
     public:
-        explicit CCSplitter() : ConditionSplitter([](const Edge &){return false;}) {}
+        explicit CCSplitter(size_t threads = 1) : ConditionSplitter([](const Edge &){return false;}, threads) {}
     };
 
     class LengthSplitter : public ConditionSplitter {
     public:
-        explicit LengthSplitter(size_t min_len) :
-                    ConditionSplitter([min_len](const Edge& edge){return edge.size() > min_len;}){
+        explicit LengthSplitter(size_t min_len, size_t threads = 1) :
+                    ConditionSplitter([min_len](const Edge& edge){return edge.size() > min_len;}, threads){
         }
     };
 
@@ -0,0 +1,97 @@
+#include "construction_cache.hpp"
+#include "common/dir_utils.hpp"
+#include "common/verify.hpp"
+#include <unistd.h>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace {
+    inline size_t mix(size_t h, size_t value) {
+        h = (h ^ value) * 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 29u);
+    }
+
+    size_t FileFingerprint(const std::experimental::filesystem::path &file) {
+        std::ifstream is;
+        is.open(file, std::ios::binary);
+        VERIFY_MSG(is.good(), "Could not open file " + file.string());
+        std::vector<char> buffer(size_t(1) << 22u);
+        size_t h = 0;
+        size_t total = 0;
+        while(is) {
+            is.read(buffer.data(), buffer.size());
+            size_t len = is.gcount();
+            total += len;
+            size_t pos = 0;
+            for(; pos + sizeof(size_t) <= len; pos += sizeof(size_t)) {
+                size_t word;
+                memcpy(&word, buffer.data() + pos, sizeof(size_t));
+                h = mix(h, word);
+            }
+            for(; pos < len; pos++) {
+                h = mix(h, (unsigned char)buffer[pos]);
+            }
+        }
+        return mix(h, total);
+    }
+}
+
+//Files are read sequentially since OpenMP can not be used before graph construction is forked
+size_t LibraryFingerprint(const io::Library &lib) {
+    size_t res = lib.size();
+    for(const std::experimental::filesystem::path &file : lib) {
+        res = mix(res, FileFingerprint(file));
+    }
+    return res;
+}
+
+ConstructionCache::ConstructionCache(logging::Logger &logger, const std::experimental::filesystem::path &cache_dir,
+                                     const io::Library &lib, const hashing::RollingHash &hasher, size_t w) :
+                                     logger(logger), cache_dir(cache_dir) {
+    logger.info() << "Computing fingerprint of reads for construction cache" << std::endl;
+    size_t fingerprint = LibraryFingerprint(lib);
+    hashing::htype base = hasher.getBase();
+//Reads are compressed by makeSequence according to these settings, so they are a part of the key too
+    size_t compression = mix(mix(mix(size_t(StringContig::homopolymer_compressing), StringContig::min_dimer_to_compress),
+                                 StringContig::max_dimer_size), StringContig::dimer_step);
+    size_t key = mix(mix(mix(mix(fingerprint, hasher.getK()), w), mix(size_t(base), size_t(base >> 64u))), compression);
+    std::stringstream ss;
+    ss << "k" << hasher.getK() << "_w" << w << "_" << std::hex << std::setw(16) << std::setfill('0') << key;
+    name = ss.str();
+    std::stringstream desc;
+    desc << "k " << hasher.getK() << "\nw " << w << "\nbase " << base << "\n";
+    desc << "homopolymer_compressing " << StringContig::homopolymer_compressing << "\n";
+    desc << "dimer_compress " << StringContig::min_dimer_to_compress << "," << StringContig::max_dimer_size << ","
+         << StringContig::dimer_step << "\n";
+    desc << "fingerprint " << std::hex << fingerprint << "\n";
+    for(const std::experimental::filesystem::path &file : lib) {
+        desc << "reads " << file.string() << "\n";
+    }
+    description = desc.str();
+}
+
+bool ConstructionCache::contains() const {
+    return std::experimental::filesystem::is_regular_file(entry() / "manifest.txt");
+}
+
+void ConstructionCache::store(const std::experimental::filesystem::path &disjointigs_file,
+                              const std::experimental::filesystem::path &vertices_file) const {
+    logger.info() << "Storing disjointigs and junctions in construction cache " << entry() << std::endl;
+    std::experimental::filesystem::path tmp = cache_dir / (name + ".tmp" + std::to_string(getpid()));
+    recreate_dir(tmp);
+    std::experimental::filesystem::copy_file(disjointigs_file, tmp / "disjointigs.fasta");
+    std::experimental::filesystem::copy_file(vertices_file, tmp / "vertices.save");
+    std::ofstream os;
+    os.open(tmp / "manifest.txt");
+    os << description;
+    os.close();
+    std::error_code ec;
+    std::experimental::filesystem::rename(tmp, entry(), ec);
+    if(ec) {
+        logger.info() << "Construction cache entry was created by another run" << std::endl;
+        std::experimental::filesystem::remove_all(tmp);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "sequences/seqio.hpp"
+#include "common/rolling_hash.hpp"
+#include "common/logging.hpp"
+#include <experimental/filesystem>
+#include <string>
+
+//Fingerprint of the contents of all files of the library. Depends on the order of the files.
+size_t LibraryFingerprint(const io::Library &lib);
+
+/*
+ * Content addressed storage of de Bruijn graph construction artifacts. Disjointigs and junctions depend only on
+ * the reads, their homopolymer and dimer compression settings, k, w and the base of the rolling hash, so every
+ * combination of these gets a separate entry in the cache directory. Reruns on the same reads with different
+ * downstream parameters reuse the entry and skip minimizer selection, disjointig construction and junction search.
+ * Entries are filled in a temporary directory and renamed, so several runs may share the same cache directory.
+ */
+class ConstructionCache {
+private:
+    logging::Logger &logger;
+    std::experimental::filesystem::path cache_dir;
+    std::string name;
+    std::string description;
+public:
+    ConstructionCache(logging::Logger &logger, const std::experimental::filesystem::path &cache_dir,
+                      const io::Library &lib, const hashing::RollingHash &hasher, size_t w);
+
+    std::experimental::filesystem::path entry() const {return cache_dir / name;}
+    std::experimental::filesystem::path disjointigs() const {return entry() / "disjointigs.fasta";}
+    std::experimental::filesystem::path vertices() const {return entry() / "vertices.save";}
+    bool contains() const;
+    void store(const std::experimental::filesystem::path &disjointigs_file,
+               const std::experimental::filesystem::path &vertices_file) const;
+};
@@ -1,25 +1,43 @@
 #include "graph_stats.hpp"
 #include "dbg_construction.hpp"
+#include "binary_vertices.hpp"
+#include "disk_buckets.hpp"
 
 using namespace hashing;
 using namespace dbg;
+
+namespace {
+    //Long disjointigs are cut into overlapping pieces so that junction search is balanced between threads
+    std::vector<Sequence> splitDisjointigs(const std::vector<Sequence> &disjointigs, size_t k) {
+        std::vector<Sequence> split_disjointigs;
+        for(const Sequence &seq : disjointigs) {
+            if(seq.size() > k * 20) {
+                size_t cur = 0;
+                while(cur + k < seq.size()) {
+                    split_disjointigs.emplace_back(seq.Subseq(cur, std::min(seq.size(), cur + k * 20)));
+                    cur += k * 19;
+                }
+            } else {
+                split_disjointigs.emplace_back(seq);
+            }
+        }
+        return std::move(split_disjointigs);
+    }
+
+    //Occurrence of a k-mer in canonical orientation. Lower four bits of extensions mark nucleotides that follow
+    //the k-mer and higher four bits mark nucleotides that precede it.
+    struct __attribute__((packed)) KmerExtensions {
+        htype hash;
+        unsigned char extensions;
+    };
+}
+
 std::vector<hashing::htype>
 findJunctions(logging::Logger &logger, const std::vector<Sequence> &disjointigs, const hashing::RollingHash &hasher,
               size_t threads) {
     bloom_parameters parameters;
     parameters.projected_element_count = std::max(total_size(disjointigs) - hasher.getK() * disjointigs.size(), size_t(1000));
-    std::vector<Sequence> split_disjointigs;
-    for(const Sequence &seq : disjointigs) {
-        if(seq.size() > hasher.getK() * 20) {
-            size_t cur = 0;
-            while(cur + hasher.getK() < seq.size()) {
-                split_disjointigs.emplace_back(seq.Subseq(cur, std::min(seq.size(), cur + hasher.getK() * 20)));
-                cur += hasher.getK() * 19;
-            }
-        } else {
-            split_disjointigs.emplace_back(seq);
-        }
-    }
+    std::vector<Sequence> split_disjointigs = splitDisjointigs(disjointigs, hasher.getK());
     parameters.false_positive_probability = 0.0001;
     VERIFY(!!parameters);
     parameters.compute_optimal_parameters();
@@ -48,7 +66,7 @@ findJunctions(logging::Logger &logger, const std::vector<Sequence> &disjointigs,
     std::pair<size_t, size_t> bits = filter.count_bits();
     logger.info() << "Filled " << bits.first << " bits out of " << bits.second << std::endl;
     logger.info() << "Finished filling bloom filter. Selecting junctions." << std::endl;
-    ParallelRecordCollector<hashing::htype> junctions(threads);
+    ParallelRecordCollector<hashing::htype> junctions(threads, CollectorMode::Unique);
     std::function<void(size_t, const Sequence &)> junk_task = [&filter, &hasher, &junctions](size_t pos, const Sequence & seq) {
         KWH kmer(hasher, seq, 0);
         size_t cnt = 0;
@@ -74,7 +92,77 @@ findJunctions(logging::Logger &logger, const std::vector<Sequence> &disjointigs,
     };
 
     processRecords(split_disjointigs.begin(), split_disjointigs.end(), logger, threads, junk_task);
-    std::vector<hashing::htype> res = junctions.collect();
+    std::vector<hashing::htype> res = junctions.collectUnique();
+    logger.info() << "Collected " << res.size() << " junctions." << std::endl;
+    return res;
+}
+
+std::vector<hashing::htype>
+findJunctions(logging::Logger &logger, const std::vector<Sequence> &disjointigs, const hashing::RollingHash &hasher,
+              size_t threads, const std::experimental::filesystem::path &dir, size_t memory_limit) {
+    std::vector<Sequence> split_disjointigs = splitDisjointigs(disjointigs, hasher.getK());
+    size_t bucket_count = BucketCount(total_size(split_disjointigs) * sizeof(KmerExtensions), memory_limit,
+                                      memory_limit / 8, sizeof(KmerExtensions), threads);
+    logger.info() << "Collecting k-mer extensions into " << bucket_count << " disk buckets." << std::endl;
+    DiskBuckets<KmerExtensions> buckets(dir, bucket_count, threads, memory_limit / 8);
+    std::function<void(size_t, const Sequence &)> task = [&hasher, &buckets](size_t pos, const Sequence & seq) {
+        size_t k = hasher.getK();
+        if(seq.size() < k)
+            return;
+        KWH kmer(hasher, seq, 0);
+        while (true) {
+            bool canonical = kmer.isCanonical();
+            unsigned char extensions = 0;
+            if(kmer.pos + k < seq.size()) {
+                unsigned char c = seq[kmer.pos + k];
+                extensions |= canonical ? 1u << c : 16u << (c ^ 3u);
+            }
+            if(kmer.pos > 0) {
+                unsigned char c = seq[kmer.pos - 1];
+                extensions |= canonical ? 16u << c : 1u << (c ^ 3u);
+            }
+            buckets.add(kmer.hash(), {kmer.hash(), extensions});
+            if (!kmer.hasNext())
+                break;
+            kmer = kmer.next();
+        }
+    };
+    processRecords(split_disjointigs.begin(), split_disjointigs.end(), logger, threads, task);
+    buckets.flush();
+    logger.info() << "Selecting junctions one bucket at a time." << std::endl;
+    std::vector<hashing::htype> res;
+    for(size_t i = 0; i < buckets.size(); i++) {
+        std::vector<KmerExtensions> bucket = buckets.load(i);
+        __gnu_parallel::sort(bucket.begin(), bucket.end(),
+                             [](const KmerExtensions &a, const KmerExtensions &b) {return a.hash < b.hash;});
+        size_t j = 0;
+        while(j < bucket.size()) {
+            htype hash = bucket[j].hash;
+            unsigned char extensions = 0;
+            for(; j < bucket.size() && bucket[j].hash == hash; j++)
+                extensions |= bucket[j].extensions;
+            if(__builtin_popcount(extensions & 15u) != 1 || __builtin_popcount(extensions >> 4u) != 1)
+                res.emplace_back(hash);
+        }
+    }
+    __gnu_parallel::sort(res.begin(), res.end());
+    ParallelRecordCollector<hashing::htype> starts(threads);
+    std::function<void(size_t, const Sequence &)> start_task = [&hasher, &res, &starts](size_t pos, const Sequence & seq) {
+        if(seq.size() < hasher.getK())
+            return;
+        KWH kmer(hasher, seq, 0);
+        while (true) {
+            if(std::binary_search(res.begin(), res.end(), kmer.hash()))
+                return;
+            if (!kmer.hasNext())
+                break;
+            kmer = kmer.next();
+        }
+        starts.emplace_back(KWH(hasher, seq, 0).hash());
+    };
+    processRecords(split_disjointigs.begin(), split_disjointigs.end(), logger, threads, start_task);
+    std::vector<hashing::htype> extra = starts.collect();
+    res.insert(res.end(), extra.begin(), extra.end());
     __gnu_parallel::sort(res.begin(), res.end());
     res.erase(std::unique(res.begin(), res.end()), res.end());
     logger.info() << "Collected " << res.size() << " junctions." << std::endl;
@@ -118,17 +206,11 @@ SparseDBG constructDBG(logging::Logger &logger, const std::vector<hashing::htype
     mergeAll(logger, dbg, threads);
     logger.info() << "Ended merging edges. Resulting size " << dbg.size() << std::endl;
     logger.trace() << "Statistics for de Bruijn graph:" << std::endl;
-    printStats(logger, dbg);
+    printStats(logger, dbg, threads);
     return std::move(dbg);
 }
 
-inline void writeHashs(std::ostream &os, const std::vector<htype> &hash_list) {
-    os << "hashes " << hash_list.size() << std::endl;
-    for (htype h : hash_list) {
-        os << h << std::endl;
-    }
-}
-
+//Text format of vertex files written by older versions
 inline std::vector<htype> readHashs(std::istream &is) {
     std::vector<htype> result;
     std::string first;
@@ -155,12 +237,15 @@ inline std::vector<htype> readHashs(std::istream &is) {
 
 SparseDBG DBGPipeline(logging::Logger &logger, const RollingHash &hasher, size_t w, const io::Library &lib,
                       const std::experimental::filesystem::path &dir, size_t threads, const string &disjointigs_file,
-                      const string &vertices_file) {
+                      const string &vertices_file, size_t memory_limit) {
     std::experimental::filesystem::path df;
     if (disjointigs_file == "none") {
-        std::function<void()> task = [&logger, &lib, &threads, &w, &dir, &hasher]() {
+        std::function<void()> task = [&logger, &lib, &threads, &w, &dir, &hasher, memory_limit]() {
             std::vector<hashing::htype> hash_list;
-            hash_list = constructMinimizers(logger, lib, threads, hasher, w);
+            if(memory_limit == 0)
+                hash_list = constructMinimizers(logger, lib, threads, hasher, w);
+            else
+                hash_list = constructMinimizers(logger, lib, threads, hasher, w, dir / "minimizer_buckets", memory_limit);
             std::vector<Sequence> disjointigs = constructDisjointigs(hasher, w, lib, hash_list, threads, logger);
             hash_list.clear();
             std::ofstream df;
@@ -184,13 +269,16 @@ SparseDBG DBGPipeline(logging::Logger &logger, const RollingHash &hasher, size_t
     }
     std::vector<hashing::htype> vertices;
     if (vertices_file == "none") {
-        vertices = findJunctions(logger, disjointigs, hasher, threads);
-        std::ofstream os;
-        os.open(std::string(dir.c_str()) + "/vertices.save");
-        writeHashs(os, vertices);
-        os.close();
-    } else {
+        if(memory_limit == 0)
+            vertices = findJunctions(logger, disjointigs, hasher, threads);
+        else
+            vertices = findJunctions(logger, disjointigs, hasher, threads, dir / "junction_buckets", memory_limit);
+        binary_vertices::Write(dir / "vertices.save", vertices, threads);
+    } else if (binary_vertices::IsBinary(vertices_file)) {
         logger.info() << "Loading vertex hashs from file " << vertices_file << std::endl;
+        vertices = binary_vertices::Read(vertices_file, threads);
+    } else {
+        logger.info() << "Loading vertex hashs from text file " << vertices_file << std::endl;
         std::ifstream is;
         is.open(vertices_file);
         vertices = readHashs(is);
@@ -198,3 +286,19 @@ SparseDBG DBGPipeline(logging::Logger &logger, const RollingHash &hasher, size_t
     }
     return std::move(constructDBG(logger, vertices, disjointigs, hasher, threads));
 }
+
+SparseDBG CachedDBGPipeline(logging::Logger &logger, const RollingHash &hasher, size_t w, const io::Library &lib,
+                            const std::experimental::filesystem::path &dir, size_t threads, const string &cache_dir,
+                            size_t memory_limit) {
+    if(cache_dir == "none")
+        return DBGPipeline(logger, hasher, w, lib, dir, threads, "none", "none", memory_limit);
+    ConstructionCache cache(logger, cache_dir, lib, hasher, w);
+    if(cache.contains()) {
+        logger.info() << "Found disjointigs and junctions for these reads in construction cache " << cache.entry() << std::endl;
+        return DBGPipeline(logger, hasher, w, lib, dir, threads, cache.disjointigs().string(), cache.vertices().string(),
+                           memory_limit);
+    }
+    SparseDBG dbg = DBGPipeline(logger, hasher, w, lib, dir, threads, "none", "none", memory_limit);
+    cache.store(dir / "disjointigs.fasta", dir / "vertices.save");
+    return std::move(dbg);
+}
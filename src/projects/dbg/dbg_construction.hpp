@@ -5,6 +5,7 @@
 
 #include "minimizer_selection.hpp"
 #include "dbg_disjointigs.hpp"
+#include "construction_cache.hpp"
 #include "sparse_dbg.hpp"
 #include "common/rolling_hash.hpp"
 #include "sequences/sequence.hpp"
@@ -17,8 +18,20 @@
 
 std::vector<hashing::htype> findJunctions(logging::Logger & logger, const std::vector<Sequence>& disjointigs,
                                  const hashing::RollingHash &hasher, size_t threads);
+//Exact junction search that collects extensions of all k-mers in disk buckets under dir instead of a bloom filter.
+//Buckets are processed one at a time so that memory usage stays within memory_limit bytes.
+std::vector<hashing::htype> findJunctions(logging::Logger & logger, const std::vector<Sequence>& disjointigs,
+                                 const hashing::RollingHash &hasher, size_t threads,
+                                 const std::experimental::filesystem::path &dir, size_t memory_limit);
 dbg::SparseDBG constructDBG(logging::Logger & logger, const std::vector<hashing::htype> &vertices,
                        const std::vector<Sequence> &disjointigs, const hashing::RollingHash &hasher, size_t threads);
 dbg::SparseDBG DBGPipeline(logging::Logger & logger, const hashing::RollingHash &hasher, size_t w, const io::Library &lib,
                                 const std::experimental::filesystem::path &dir, size_t threads,
-                                const std::string& disjointigs_file = "none", const std::string &vertices_file = "none");
\ No newline at end of file
+                                const std::string& disjointigs_file = "none", const std::string &vertices_file = "none",
+                                size_t memory_limit = 0);
+
+//Same as DBGPipeline but disjointigs and junctions are taken from the construction cache in cache_dir if they were
+//computed for the same reads and parameters before. Cache is not used if cache_dir is none.
+dbg::SparseDBG CachedDBGPipeline(logging::Logger & logger, const hashing::RollingHash &hasher, size_t w, const io::Library &lib,
+                                 const std::experimental::filesystem::path &dir, size_t threads, const std::string &cache_dir,
+                                 size_t memory_limit = 0);
@@ -157,7 +157,7 @@ std::vector<Sequence> constructDisjointigs(const RollingHash &hasher, size_t w,
 
     tieTips(logger, sdbg, w, threads);
     sdbg.checkSeqFilled(threads, logger);
-    printStats(logger, sdbg);
+    printStats(logger, sdbg, threads);
 //    std::ofstream os;
 //    os.open("sdbg.fasta");
 //    sdbg.printReadFasta(os);
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "common/hash_utils.hpp"
+#include "common/dir_utils.hpp"
+#include "common/verify.hpp"
+#include <omp.h>
+#include <algorithm>
+#include <experimental/filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//Write buffers of DiskBuckets should hold at least this many records, otherwise appends to bucket files become too small
+const size_t MIN_BUCKET_BUFFER = 256;
+
+//Smallest power of two number of buckets such that a single bucket is expected to take at most a quarter of the memory limit.
+//The number of buckets is also limited so that buffers of MIN_BUCKET_BUFFER records for every thread and bucket fit into
+//buffer_bytes. If memory limit is too small for both conditions buckets get larger than a quarter of the limit.
+inline size_t BucketCount(size_t estimated_bytes, size_t memory_limit, size_t buffer_bytes, size_t record_size, size_t threads) {
+    size_t max_buckets = buffer_bytes / (MIN_BUCKET_BUFFER * record_size * std::max<size_t>(1, threads));
+    size_t res = 1;
+    while(res < 4096 && res * 2 <= max_buckets && estimated_bytes / res > memory_limit / 4)
+        res *= 2;
+    return res;
+}
+
+/*
+ * External memory storage of records that are distributed into files by a 128-bit key. Keys are mixed before
+ * bucket selection since minimizer hashes are far from uniform, so buckets are not ordered by key and all records
+ * with the same key end up in the same bucket.
+ * Every thread keeps a small buffer for each bucket and appends it to the bucket file when it is full.
+ * Buckets are read back one at a time, so that only a single bucket has to fit into memory.
+ * Records are written as raw bytes and should be trivially copyable.
+ */
+template<class T>
+class DiskBuckets {
+private:
+    std::experimental::filesystem::path dir;
+    size_t bits = 0;
+    size_t buffer_size;
+    std::vector<std::vector<std::vector<T>>> buffers;
+    std::vector<std::mutex> locks;
+    std::vector<size_t> sizes;
+
+    std::experimental::filesystem::path file(size_t bucket) const {
+        return dir / (std::to_string(bucket) + ".bin");
+    }
+
+    void flush(size_t bucket, std::vector<T> &buffer) {
+        std::lock_guard<std::mutex> guard(locks[bucket]);
+        std::ofstream os;
+        os.open(file(bucket), std::ios::binary | std::ios::app);
+        os.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() * sizeof(T));
+        VERIFY_MSG(os.good(), "Failed to write to " + file(bucket).string());
+        os.close();
+        sizes[bucket] += buffer.size();
+        buffer.clear();
+    }
+
+public:
+    //bucket_count should be a power of two. All thread buffers together take at most buffer_bytes of memory unless
+    //a single record per buffer does not fit, so bucket_count should be chosen with BucketCount.
+    DiskBuckets(const std::experimental::filesystem::path &dir, size_t bucket_count, size_t threads, size_t buffer_bytes) :
+                dir(dir), buffer_size(std::max<size_t>(1, buffer_bytes / sizeof(T) / threads / bucket_count)),
+                buffers(threads, std::vector<std::vector<T>>(bucket_count)), locks(bucket_count), sizes(bucket_count) {
+        VERIFY((bucket_count & (bucket_count - 1)) == 0);
+        while((size_t(1) << bits) < bucket_count)
+            bits++;
+        recreate_dir(dir);
+    }
+
+    DiskBuckets(const DiskBuckets &) = delete;
+    DiskBuckets &operator=(const DiskBuckets &) = delete;
+
+    ~DiskBuckets() {
+        std::experimental::filesystem::remove_all(dir);
+    }
+
+    size_t size() const {
+        return sizes.size();
+    }
+
+    size_t bucket(hashing::htype key) const {
+        if(bits == 0)
+            return 0;
+        size_t mixed = (size_t(key) ^ size_t(key >> 64u)) * 0x9E3779B97F4A7C15ull;
+        return mixed >> (64u - bits);
+    }
+
+    //Can be called from parallel regions. Every thread uses its own buffers.
+    void add(hashing::htype key, const T &value) {
+        size_t b = bucket(key);
+        std::vector<T> &buffer = buffers[omp_get_thread_num()][b];
+        buffer.emplace_back(value);
+        if(buffer.size() >= buffer_size)
+            flush(b, buffer);
+    }
+
+    //Should be called after all records were added and before buckets are loaded
+    void flush() {
+        for(std::vector<std::vector<T>> &thread_buffers : buffers) {
+            for(size_t b = 0; b < thread_buffers.size(); b++) {
+                if(!thread_buffers[b].empty())
+                    flush(b, thread_buffers[b]);
+                std::vector<T>().swap(thread_buffers[b]);
+            }
+        }
+    }
+
+    //Reads all records of the bucket in the order they were written and removes the bucket file
+    std::vector<T> load(size_t bucket) {
+        std::vector<T> res(sizes[bucket]);
+        if(res.empty())
+            return std::move(res);
+        std::ifstream is;
+        is.open(file(bucket), std::ios::binary);
+        is.read(reinterpret_cast<char *>(res.data()), res.size() * sizeof(T));
+        VERIFY_MSG(is.good(), "Failed to read " + file(bucket).string());
+        is.close();
+        std::experimental::filesystem::remove(file(bucket));
+        return std::move(res);
+    }
+};
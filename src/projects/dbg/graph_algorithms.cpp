@@ -329,6 +329,8 @@ namespace dbg {
             sequences.add(seq);
         };
         processRecords(reader.begin(), reader.end(), logger, threads, collect_task);
+        //Vertices are inserted in the order they were collected. Map iteration order depends on it and defines edge ids
+        //of the multiplex graph, so presizing the map or sorting the hashes would renumber edges of the final assembly.
         SparseDBG res(vertices.begin(), vertices.end(), hasher);
         reader.reset();
         FillSparseDBGEdges(res, sequences.begin(), sequences.end(), logger, threads, hasher.getK() + 1);
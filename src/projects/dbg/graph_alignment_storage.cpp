@@ -1,4 +1,5 @@
 #include "graph_alignment_storage.hpp"
+#include "binary_io.hpp"
 
 using namespace dbg;
 void AlignedRead::correct(CompactPath &&cpath) {
@@ -411,14 +412,75 @@ void RecordStorage::removeSubpath(const CompactPath &cpath) {
     processPath(cpath, vertex_task, edge_task);
 }
 
+//Lengths of the longest common prefix and suffix of two sequences of events that do not overlap
+template<class T, class Eq>
+static std::pair<size_t, size_t> commonEnds(const std::vector<T> &a, const std::vector<T> &b, const Eq &eq) {
+    size_t prefix = 0;
+    while(prefix < a.size() && prefix < b.size() && eq(a[prefix], b[prefix]))
+        prefix++;
+    size_t suffix = 0;
+    while(suffix + prefix < a.size() && suffix + prefix < b.size() &&
+                eq(a[a.size() - 1 - suffix], b[b.size() - 1 - suffix]))
+        suffix++;
+    return {prefix, suffix};
+}
+
+void RecordStorage::collectSubpath(const CompactPath &cpath, std::vector<std::pair<Vertex *, Sequence>> &suffixes,
+                                   std::vector<Segment<Edge>> &segments) const {
+    std::function<void(Vertex &, const Sequence &)> vertex_task = [](Vertex &v, const Sequence &s) {};
+    if(track_suffixes)
+        vertex_task = [&suffixes](Vertex &v, const Sequence &s) {
+            suffixes.emplace_back(&v, s);
+        };
+    std::function<void(Segment<Edge>)> edge_task = [](Segment<Edge> seg){};
+    if(track_cov)
+        edge_task = [&segments](Segment<Edge> seg) {
+            segments.emplace_back(seg);
+        };
+    processPath(cpath, vertex_task, edge_task);
+}
+
+void RecordStorage::replaceSubpath(const CompactPath &old_path, const CompactPath &new_path) {
+    if(!old_path.valid() || !new_path.valid()) {
+        removeSubpath(old_path);
+        addSubpath(new_path);
+        return;
+    }
+    std::vector<std::pair<Vertex *, Sequence>> old_suffixes;
+    std::vector<std::pair<Vertex *, Sequence>> new_suffixes;
+    std::vector<Segment<Edge>> old_segments;
+    std::vector<Segment<Edge>> new_segments;
+    collectSubpath(old_path, old_suffixes, old_segments);
+    collectSubpath(new_path, new_suffixes, new_segments);
+    std::pair<size_t, size_t> same_segments = commonEnds(old_segments, new_segments,
+            [](const Segment<Edge> &a, const Segment<Edge> &b) {
+                return &a.contig() == &b.contig() && a.size() == b.size();
+            });
+    for(size_t i = same_segments.first; i + same_segments.second < old_segments.size(); i++) {
+        old_segments[i].contig().incCov(size_t(-old_segments[i].size()));
+    }
+    for(size_t i = same_segments.first; i + same_segments.second < new_segments.size(); i++) {
+        new_segments[i].contig().incCov(new_segments[i].size());
+    }
+    std::pair<size_t, size_t> same_suffixes = commonEnds(old_suffixes, new_suffixes,
+            [](const std::pair<Vertex *, Sequence> &a, const std::pair<Vertex *, Sequence> &b) {
+                return a.first == b.first && a.second == b.second;
+            });
+    for(size_t i = same_suffixes.first; i + same_suffixes.second < old_suffixes.size(); i++) {
+        data.find(old_suffixes[i].first)->second.removePath(old_suffixes[i].second);
+    }
+    for(size_t i = same_suffixes.first; i + same_suffixes.second < new_suffixes.size(); i++) {
+        data.find(new_suffixes[i].first)->second.addPath(new_suffixes[i].second);
+    }
+}
+
 bool RecordStorage::apply(AlignedRead &alignedRead) {
     if(!alignedRead.checkCorrected())
         return false;
-    this->removeSubpath(alignedRead.path);
-    this->removeSubpath(alignedRead.path.RC());
+    CompactPath old_path = alignedRead.path;
     alignedRead.applyCorrection();
-    this->addSubpath(alignedRead.path);
-    this->addSubpath(alignedRead.path.RC());
+    this->replaceSubpath(old_path, alignedRead.path);
+    this->replaceSubpath(old_path.RC(), alignedRead.path.RC());
     return true;
 }
 
@@ -482,9 +544,13 @@ void RecordStorage::printReadFasta(logging::Logger &logger, const std::experimen
 
 void RecordStorage::printFullAlignments(logging::Logger &logger, const std::experimental::filesystem::path &path) const {
     logger.info() << "Printing read to graph alignenments to file " << path << std::endl;
-    std::string acgt = "ACGT";
     std::ofstream os;
     os.open(path);
+    printFullAlignments(os);
+    os.close();
+}
+
+void RecordStorage::printFullAlignments(std::ostream &os) const {
     for(const AlignedRead &read : reads) {
         const CompactPath &al = read.path;
         if(!al.valid())
@@ -508,7 +574,6 @@ void RecordStorage::printFullAlignments(logging::Logger &logger, const std::expe
 //        os << read.id << " " << read.path.getAlignment().str(true) << "\n";
 //        os << "-" << read.id << " " << read.path.getAlignment().RC().str(true) << "\n";
     }
-    os.close();
 }
 
 //void RecordStorage::updateExtensionSize(logging::Logger &logger, size_t threads, size_t new_max_extension) {
@@ -574,6 +639,51 @@ void RecordStorage::Load(std::istream &is, SparseDBG &dbg) {
     }
 }
 
+void RecordStorage::SaveBinary(std::ostream &os) const {
+    binary_io::Write<uint64_t>(os, min_len);
+    binary_io::Write<uint64_t>(os, max_len);
+    binary_io::Write<bool>(os, track_cov);
+    binary_io::Write<bool>(os, track_suffixes);
+    binary_io::Write<bool>(os, log_changes);
+    binary_io::Write<uint64_t>(os, reads.size());
+    for(const AlignedRead &read : reads) {
+        binary_io::WriteString(os, read.id);
+        const CompactPath &path = read.path;
+        binary_io::Write<bool>(os, path.valid());
+        if(!path.valid())
+            continue;
+        binary_io::Write<hashing::htype>(os, path.start().hash());
+        binary_io::Write<bool>(os, path.start().isCanonical());
+        binary_io::Write<uint64_t>(os, path.leftSkip());
+        binary_io::Write<uint64_t>(os, path.rightSkip());
+        binary_io::WriteSequence(os, path.cpath());
+    }
+}
+
+void RecordStorage::LoadBinary(logging::Logger &logger, size_t threads, std::istream &is, SparseDBG &dbg) {
+    untrackSuffixes();
+    min_len = binary_io::Read<uint64_t>(is);
+    max_len = binary_io::Read<uint64_t>(is);
+    track_cov = binary_io::Read<bool>(is);
+    bool load_suffixes = binary_io::Read<bool>(is);
+    log_changes = binary_io::Read<bool>(is);
+    reads.clear();
+    reads.resize(binary_io::Read<uint64_t>(is));
+    for(AlignedRead &read : reads) {
+        read.id = binary_io::ReadString(is);
+        if(!binary_io::Read<bool>(is))
+            continue;
+        hashing::htype hash = binary_io::Read<hashing::htype>(is);
+        bool canonical = binary_io::Read<bool>(is);
+        size_t left = binary_io::Read<uint64_t>(is);
+        size_t right = binary_io::Read<uint64_t>(is);
+        Sequence edges = binary_io::ReadSequence(is);
+        read.path = {dbg.getVertex(hash, canonical), edges, left, right};
+    }
+    if(load_suffixes)
+        trackSuffixes(logger, threads);
+}
+
 void SaveAllReads(const std::experimental::filesystem::path &fname, const std::vector<RecordStorage *> &recs) {
     std::ofstream os;
     os.open(fname);
@@ -121,6 +121,42 @@ public:
     }
 };
 
+//Iterates over corrected sequences of reads with valid alignments in the form they are printed by printReadFasta,
+//so that corrected reads can be handed to the next stage without writing them to disk
+class CorrectedReadIterator {
+private:
+    std::vector<AlignedRead>::const_iterator it;
+    std::vector<AlignedRead>::const_iterator end;
+
+    void skipInvalid() {
+        while(it != end && !it->path.valid())
+            ++it;
+    }
+public:
+    typedef StringContig value_type;
+
+    CorrectedReadIterator(std::vector<AlignedRead>::const_iterator it, std::vector<AlignedRead>::const_iterator end) :
+                it(it), end(end) {
+        skipInvalid();
+    }
+
+    void operator++() {
+        ++it;
+        skipInvalid();
+    }
+
+    StringContig operator*() const {
+        return {it->path.getAlignment().Seq().str(), std::string(it->id)};
+    }
+
+    bool operator==(const CorrectedReadIterator &other) const {
+        return it == other.it;
+    }
+
+    bool operator!=(const CorrectedReadIterator &other) const {
+        return it != other.it;
+    }
+};
 
 class RecordStorage {
 private:
@@ -137,6 +173,9 @@ public:
 private:
     void processPath(const dbg::CompactPath &cpath, const std::function<void(dbg::Vertex &, const Sequence &)> &task,
                             const std::function<void(Segment<dbg::Edge>)> &edge_task = [](Segment<dbg::Edge>){}) const;
+    //Suffixes and edge segments that addSubpath would store for the path
+    void collectSubpath(const dbg::CompactPath &cpath, std::vector<std::pair<dbg::Vertex *, Sequence>> &suffixes,
+                        std::vector<Segment<dbg::Edge>> &segments) const;
 public:
     RecordStorage(dbg::SparseDBG &dbg, size_t _min_len, size_t _max_len, size_t threads,
                   ReadLogger &readLogger, bool _track_cov = false, bool log_changes = false, bool track_suffixes = true);
@@ -154,6 +193,8 @@ public:
     iterator end() {return reads.end();}
     const_iterator begin() const {return reads.begin();}
     const_iterator end() const {return reads.end();}
+    CorrectedReadIterator correctedBegin() const {return {reads.begin(), reads.end()};}
+    CorrectedReadIterator correctedEnd() const {return {reads.end(), reads.end()};}
     AlignedRead &operator[](size_t ind) {return reads[ind];}
     const AlignedRead &operator[](size_t ind) const {return reads[ind];}
     size_t getMinLen() const {return min_len;}
@@ -166,6 +207,9 @@ public:
 
     void addSubpath(const dbg::CompactPath &cpath);
     void removeSubpath(const dbg::CompactPath &cpath);
+    //Updates edge coverage and stored suffixes only for the part of the read path that was changed by correction.
+    //Both paths are still walked edge by edge to find that part, only the updates are restricted to it.
+    void replaceSubpath(const dbg::CompactPath &old_path, const dbg::CompactPath &new_path);
     void addRead(AlignedRead &&read);
     void invalidateRead(AlignedRead &read, const std::string &message);
     void reroute(AlignedRead &alignedRead, const dbg::GraphAlignment &initial, const dbg::GraphAlignment &corrected, const std::string &message);
@@ -186,12 +230,18 @@ public:
     void printReadAlignments(logging::Logger &logger, const std::experimental::filesystem::path &path) const;
     void printReadFasta(logging::Logger &logger, const std::experimental::filesystem::path &path) const;
     void printFullAlignments(logging::Logger &logger, const std::experimental::filesystem::path &path) const;
+    void printFullAlignments(std::ostream &os) const;
     ReadLogger &getLogger() {return *readLogger;}
     void flush() {readLogger->flush();}
 
     void Save(std::ostream &os) const;
 
     void Load(std::istream &is, dbg::SparseDBG &dbg);
+
+    //Binary snapshot of the storage parameters and read paths. Edge coverage is not changed by loading since it is
+    //saved together with the graph. Read suffixes are collected again if the storage tracks them.
+    void SaveBinary(std::ostream &os) const;
+    void LoadBinary(logging::Logger &logger, size_t threads, std::istream &is, dbg::SparseDBG &dbg);
 };
 
 void SaveAllReads(const std::experimental::filesystem::path &fname, const std::vector<RecordStorage *> &recs);
@@ -125,7 +125,7 @@ void RemoveUncovered(logging::Logger &logger, size_t threads, SparseDBG &dbg, co
         VERIFY(subgraph.isAnchor(vit.first) || subgraph.containsVertex(vit.first))
     }
     mergeAll(logger, subgraph, threads);
-    printStats(logger, subgraph);
+    printStats(logger, subgraph, threads);
     subgraph.fillAnchors(min_len, logger, threads, anchors);
 //    subgraph.checkDBGConsistency(threads, logger);
     logger.trace() << "Constructing embedding of old graph into new" << std::endl;
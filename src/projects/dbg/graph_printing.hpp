@@ -2,6 +2,7 @@
 
 #include "component.hpp"
 #include "sparse_dbg.hpp"
+#include "common/parallel_output.hpp"
 namespace dbg {
     inline void printFasta(std::ostream &out, const Component &component, bool mask = false) {
         size_t cnt = 0;
@@ -85,39 +86,72 @@ namespace dbg {
         out.close();
     }
 
-    inline void printGFA(std::ostream &out, const Component &component, bool calculate_coverage) {
+    //Segments and links are formatted in parallel in the order in which they are listed in the component
+    inline void printGFA(std::ostream &out, const Component &component, bool calculate_coverage, size_t threads = 1) {
         out << "H\tVN:Z:1.0" << std::endl;
-        size_t cnt = 0;
+        std::vector<Edge *> segments;
         std::unordered_map<const Edge *, std::string> eids;
         for (Edge &edge : component.edges()) {
             if (edge.start()->isCanonical(edge)) {
+                segments.emplace_back(&edge);
                 eids[&edge] = edge.oldId();
                 eids[&edge.rc()] = edge.oldId();
-                if (calculate_coverage)
-                    out << "S\t" << edge.oldId() << "\t" << edge.start()->seq << edge.seq
-                        << "\tKC:i:" << edge.intCov() << "\n";
-                else
-                    out << "S\t" << edge.oldId() << "\t" << edge.start()->seq << edge.seq << "\n";
             }
         }
+        std::function<void(size_t, std::string &)> segment_task =
+                [&segments, &eids, calculate_coverage](size_t num, std::string &buffer) {
+            Edge &edge = *segments[num];
+            buffer += "S\t";
+            buffer += eids.find(&edge)->second;
+            buffer += "\t";
+            edge.start()->seq.appendStr(buffer);
+            edge.seq.appendStr(buffer);
+            if (calculate_coverage) {
+                buffer += "\tKC:i:";
+                buffer += itos(edge.intCov());
+            }
+            buffer += "\n";
+        };
+        std::function<size_t(size_t)> segment_size = [&segments](size_t num) {
+            return segments[num]->start()->seq.size() + segments[num]->size() + 70;
+        };
+        ParallelPrint(out, segments.size(), threads, segment_task, segment_size);
+        std::vector<Vertex *> link_vertices;
         for (Vertex &vertex : component.verticesUnique()) {
+            link_vertices.emplace_back(&vertex);
+        }
+        std::string overlap = "\t" + itos(component.graph().hasher().getK()) + "M\n";
+        std::function<void(size_t, std::string &)> link_task =
+                [&link_vertices, &eids, &overlap](size_t num, std::string &buffer) {
+            Vertex &vertex = *link_vertices[num];
             for (const Edge &out_edge : vertex) {
-                std::string outid = eids[&out_edge];
+                auto out_it = eids.find(&out_edge);
                 bool outsign = vertex.isCanonical(out_edge);
                 for (const Edge &inc_edge : vertex.rc()) {
-                    std::string incid = eids[&inc_edge];
+                    auto inc_it = eids.find(&inc_edge);
                     bool incsign = !vertex.rc().isCanonical(inc_edge);
-                    out << "L\t" << incid << "\t" << (incsign ? "+" : "-") << "\t" << outid << "\t"
-                        << (outsign ? "+" : "-") << "\t" << component.graph().hasher().getK() << "M" << "\n";
+                    buffer += "L\t";
+                    if (inc_it != eids.end())
+                        buffer += inc_it->second;
+                    buffer += incsign ? "\t+\t" : "\t-\t";
+                    if (out_it != eids.end())
+                        buffer += out_it->second;
+                    buffer += outsign ? "\t+" : "\t-";
+                    buffer += overlap;
                 }
             }
-        }
+        };
+        std::function<size_t(size_t)> link_size = [&link_vertices](size_t num) {
+            return link_vertices[num]->outDeg() * link_vertices[num]->inDeg() * 100;
+        };
+        ParallelPrint(out, link_vertices.size(), threads, link_task, link_size);
     }
 
-    inline void printGFA(const std::experimental::filesystem::path &outf, const Component &component, bool calculate_coverage) {
+    inline void printGFA(const std::experimental::filesystem::path &outf, const Component &component, bool calculate_coverage,
+                         size_t threads = 1) {
         std::ofstream out;
         out.open(outf);
-        printGFA(out, component, calculate_coverage);
+        printGFA(out, component, calculate_coverage, threads);
         out.close();
     }
 }
\ No newline at end of file
@@ -24,7 +24,7 @@ inline void simpleStats(logging::Logger &logger, dbg::SparseDBG &dbg) {
     logger << "Unique edge total length: " << elen / 2 << std::endl;
 }
 
-inline void printStats(logging::Logger &logger, dbg::SparseDBG &dbg) {
+inline void printStats(logging::Logger &logger, dbg::SparseDBG &dbg, size_t threads = 1) {
     std::vector<size_t> arr(10);
     size_t isolated = 0;
     size_t isolatedSize = 0;
@@ -93,7 +93,7 @@ inline void printStats(logging::Logger &logger, dbg::SparseDBG &dbg) {
     logger << "Total vertices: " << dbg.size() << std::endl;
     logger << "Number of end vertices: " << n01 << std::endl;
     logger << "Number of unbranching vertices: " << n11 << std::endl;
-    logger << "Number of connected components: " << dbg::CCSplitter().split(dbg::Component(dbg)).size() << std::endl;
+    logger << "Number of connected components: " << dbg::CCSplitter(threads).split(dbg::Component(dbg)).size() << std::endl;
     logger << "Number of isolated edges " << isolated / 2 << " " << isolatedSize / 2 << std::endl;
 //    logger << "Distribution of degrees:" << std::endl;
 //    for (size_t i = 0; i < arr.size(); i++) {
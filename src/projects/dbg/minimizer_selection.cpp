@@ -1,4 +1,6 @@
 #include "minimizer_selection.hpp"
+#include "disk_buckets.hpp"
+#include "common/string_utils.hpp"
 
 using namespace hashing;
 std::vector<htype>
@@ -10,7 +12,7 @@ constructMinimizers(logging::Logger &logger, const io::Library &reads_file, size
     const size_t buffer_size = 1000000000;
     logger.info() << "Extracting minimizers" << std::endl;
     size_t min_read_size = hasher.getK() + w - 1;
-    ParallelRecordCollector<htype> hashs(threads);
+    ParallelRecordCollector<htype> hashs(threads, CollectorMode::Unique);
     std::function<void(size_t, StringContig &)> task = [min_read_size, w, &hasher, &hashs](size_t pos, StringContig & contig) {
         Sequence seq = contig.makeSequence();
         if(seq.size() >= min_read_size) {
@@ -38,3 +40,49 @@ constructMinimizers(logging::Logger &logger, const io::Library &reads_file, size
     }
     return hash_list;
 }
+
+std::vector<htype>
+constructMinimizers(logging::Logger &logger, const io::Library &reads_file, size_t threads, const RollingHash &hasher,
+                    const size_t w, const std::experimental::filesystem::path &dir, size_t memory_limit) {
+    size_t reads_size = 0;
+    for(const std::experimental::filesystem::path &file : reads_file) {
+        size_t file_size = std::experimental::filesystem::file_size(file);
+        reads_size += endsWith(file.string(), ".gz") ? file_size * 4 : file_size;
+    }
+    size_t bucket_count = BucketCount(reads_size / (w + 1) * 2 * sizeof(htype), memory_limit,
+                                      memory_limit / 8, sizeof(htype), threads);
+    logger.info() << "Extracting minimizers into " << bucket_count << " disk buckets" << std::endl;
+    size_t min_read_size = hasher.getK() + w - 1;
+    DiskBuckets<htype> buckets(dir, bucket_count, threads, memory_limit / 8);
+    std::function<void(size_t, StringContig &)> task = [min_read_size, w, &hasher, &buckets](size_t pos, StringContig & contig) {
+        Sequence seq = contig.makeSequence();
+        if(seq.size() >= min_read_size) {
+            MinimizerCalculator calc(seq, hasher, w);
+            std::vector<htype> minimizers(calc.minimizerHashs());
+            if (minimizers.size() > 10) {
+                std::sort(minimizers.begin(), minimizers.end());
+                minimizers.erase(std::unique(minimizers.begin(), minimizers.end()), minimizers.end());
+            }
+            for(htype minimizer : minimizers) {
+                buckets.add(minimizer, minimizer);
+            }
+        }
+    };
+    io::SeqReader reader(reads_file, (hasher.getK() + w) * 20, (hasher.getK() + w) * 4);
+    processRecords(reader.begin(), reader.end(), logger, threads, task);
+    buckets.flush();
+    logger.info() << "Finished read processing. Deduplicating minimizers one bucket at a time." << std::endl;
+    std::vector<htype> hash_list;
+    for(size_t i = 0; i < buckets.size(); i++) {
+        std::vector<htype> bucket = buckets.load(i);
+        __gnu_parallel::sort(bucket.begin(), bucket.end());
+        bucket.erase(std::unique(bucket.begin(), bucket.end()), bucket.end());
+        hash_list.insert(hash_list.end(), bucket.begin(), bucket.end());
+    }
+    __gnu_parallel::sort(hash_list.begin(), hash_list.end());
+    logger.info() << "Finished sorting. Total distinct minimizers: " << hash_list.size() << std::endl;
+    if (hash_list.size() == 0) {
+        logger.info() << "WARNING: no reads passed the length filter " << min_read_size << "." << std::endl;
+    }
+    return hash_list;
+}
@@ -9,7 +9,13 @@
 #include "sequences/seqio.hpp"
 #include "common/logging.hpp"
 #include "common/omp_utils.hpp"
+#include <experimental/filesystem>
 
 std::vector<hashing::htype> constructMinimizers(logging::Logger &logger, const io::Library &reads_file, size_t threads,
                                        const hashing::RollingHash &hasher, const size_t w);
 
+//Same as above but minimizers are deduplicated in disk buckets under dir so that memory usage during sorting stays
+//within memory_limit bytes. Only the resulting list of distinct minimizers is kept in memory.
+std::vector<hashing::htype> constructMinimizers(logging::Logger &logger, const io::Library &reads_file, size_t threads,
+                                                const hashing::RollingHash &hasher, const size_t w,
+                                                const std::experimental::filesystem::path &dir, size_t memory_limit);
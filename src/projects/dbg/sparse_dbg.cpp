@@ -1,4 +1,6 @@
 #include "sparse_dbg.hpp"
+#include "binary_io.hpp"
+#include "common/parallel_output.hpp"
 using namespace dbg;
 
 Edge Edge::_fake = Edge(nullptr, nullptr, Sequence());
@@ -668,14 +670,88 @@ std::vector<hashing::KWH> SparseDBG::extractVertexPositions(const Sequence &seq,
     return std::move(res);
 }
 
-void SparseDBG::printFastaOld(const std::experimental::filesystem::path &out) {
+void SparseDBG::printFastaOld(const std::experimental::filesystem::path &out, size_t threads) {
     std::ofstream os;
     os.open(out);
+    printFastaOld(os, threads);
+    os.close();
+}
+
+void SparseDBG::printFastaOld(std::ostream &os, size_t threads) {
+    std::vector<Edge *> edge_list;
     for(Edge &edge : edges()) {
-        os << ">" << edge.start()->hash() << edge.start()->isCanonical() << "ACGT"[edge.seq[0]] << "\n" <<
-           edge.start()->seq << edge.seq << "\n";
+        edge_list.emplace_back(&edge);
+    }
+    std::function<void(size_t, std::string &)> format = [&edge_list](size_t num, std::string &buffer) {
+        Edge &edge = *edge_list[num];
+        buffer += ">";
+        buffer += edge.oldId();
+        buffer += "\n";
+        edge.start()->seq.appendStr(buffer);
+        edge.seq.appendStr(buffer);
+        buffer += "\n";
+    };
+    std::function<size_t(size_t)> estimate = [&edge_list](size_t num) {
+        return edge_list[num]->start()->seq.size() + edge_list[num]->size() + 45;
+    };
+    ParallelPrint(os, edge_list.size(), threads, format, estimate);
+}
+
+void SparseDBG::saveBinary(std::ostream &os) {
+    binary_io::Write<uint64_t>(os, hasher().getK());
+    binary_io::Write<uint64_t>(os, size());
+    for(auto &it : v) {
+        Vertex &vert = it.second;
+        binary_io::Write<hashing::htype>(os, vert.hash());
+        binary_io::Write<uint64_t>(os, vert.coverage());
+        binary_io::WriteSequence(os, vert.seq);
     }
-    os.close();
+    for(auto &it : v) {
+        for(Vertex *vert : {&it.second, &it.second.rc()}) {
+            binary_io::Write<uint64_t>(os, vert->outDeg());
+            for(Edge &edge : *vert) {
+                binary_io::Write<hashing::htype>(os, edge.end()->hash());
+                binary_io::Write<bool>(os, edge.end()->isCanonical());
+                binary_io::Write<uint64_t>(os, edge.intCov());
+                binary_io::Write<bool>(os, edge.is_reliable);
+                binary_io::WriteSequence(os, edge.seq);
+            }
+        }
+    }
+}
+
+SparseDBG SparseDBG::loadBinary(std::istream &is, const hashing::RollingHash &hasher) {
+    VERIFY_MSG(binary_io::Read<uint64_t>(is) == hasher.getK(), "Binary graph was saved with different k");
+    SparseDBG res(hasher);
+    size_t size = binary_io::Read<uint64_t>(is);
+    std::vector<Vertex *> order;
+    order.reserve(size);
+    for(size_t i = 0; i < size; i++) {
+        Vertex &vert = res.innerAddVertex(binary_io::Read<hashing::htype>(is));
+        vert.coverage_ = binary_io::Read<uint64_t>(is);
+        vert.rc().coverage_ = vert.coverage_;
+        Sequence seq = binary_io::ReadSequence(is);
+        if(!seq.empty())
+            vert.setSequence(seq);
+        order.emplace_back(&vert);
+    }
+    for(Vertex *canonical : order) {
+        for(Vertex *vert : {canonical, &canonical->rc()}) {
+            size_t deg = binary_io::Read<uint64_t>(is);
+            vert->outgoing_.reserve(deg);
+            for(size_t i = 0; i < deg; i++) {
+                hashing::htype end_hash = binary_io::Read<hashing::htype>(is);
+                bool end_canonical = binary_io::Read<bool>(is);
+                size_t cov = binary_io::Read<uint64_t>(is);
+                bool reliable = binary_io::Read<bool>(is);
+                Sequence seq = binary_io::ReadSequence(is);
+                vert->outgoing_.emplace_back(vert, &res.getVertex(end_hash, end_canonical), seq);
+                vert->outgoing_.back().incCov(cov);
+                vert->outgoing_.back().is_reliable = reliable;
+            }
+        }
+    }
+    return std::move(res);
 }
 
 void SparseDBG::processRead(const Sequence &seq) {
@@ -208,7 +208,11 @@ namespace dbg {
 
 
         std::vector<hashing::KWH> extractVertexPositions(const Sequence &seq, size_t max = size_t(-1)) const;
-        void printFastaOld(const std::experimental::filesystem::path &out);
+        void printFastaOld(const std::experimental::filesystem::path &out, size_t threads = 1);
+        void printFastaOld(std::ostream &os, size_t threads = 1);
+        //Binary snapshot of vertices, edges and coverages. Anchors are not saved and should be filled after loading.
+        void saveBinary(std::ostream &os);
+        static SparseDBG loadBinary(std::istream &is, const hashing::RollingHash &hasher);
 
         IterableStorage<ApplyingIterator<vertex_iterator_type, Vertex, 2>> vertices(bool unique = false);
         IterableStorage<ApplyingIterator<vertex_iterator_type, Vertex, 2>> verticesUnique();
@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <utility>
 #include "component.hpp"
+#include "common/parallel_output.hpp"
 
 class GraphAlignmentStorage {
 private:
@@ -115,8 +116,9 @@ namespace std {
     }
 }
 
+//Edges are formatted in parallel if threads is more than one. In this case labeler and colorer should be thread safe.
 inline void printDot(std::ostream &os, const dbg::Component &component, const std::function<std::string(dbg::Edge &)> &labeler,
-              const std::function<std::string(dbg::Edge &)> &edge_colorer) {
+              const std::function<std::string(dbg::Edge &)> &edge_colorer, size_t threads = 1) {
     os << "digraph {\nnodesep = 0.5;\n";
     std::unordered_set<hashing::htype, hashing::alt_hasher<hashing::htype>> extended;
     for(dbg::Edge &edge : component.edgesUnique()) {
@@ -130,9 +132,19 @@ inline void printDot(std::ostream &os, const dbg::Component &component, const st
             os << vert.getShortId() << " [style=filled fillcolor=\"" + color + "\"]\n";
         }
     }
+    std::vector<dbg::Edge *> edges;
     for(dbg::Edge &edge : component.edges()) {
-        printEdge(os, edge, labeler(edge), edge_colorer(edge));
+        edges.emplace_back(&edge);
     }
+    std::function<void(size_t, std::string &)> format = [&edges, &labeler, &edge_colorer](size_t num, std::string &buffer) {
+        std::ostringstream ss;
+        printEdge(ss, *edges[num], labeler(*edges[num]), edge_colorer(*edges[num]));
+        buffer += ss.str();
+    };
+    std::function<size_t(size_t)> estimate = [](size_t) {
+        return size_t(100);
+    };
+    ParallelPrint(os, edges.size(), threads, format, estimate);
     os << "}\n";
 }
 
@@ -143,9 +155,10 @@ inline void printDot(std::ostream &os, const dbg::Component &component) {
     printDot(os, component, labeler, colorer);
 }
 
-inline void printDot(std::ostream &os, const dbg::Component &component, const std::function<std::string(dbg::Edge &)> &labeler) {
+inline void printDot(std::ostream &os, const dbg::Component &component, const std::function<std::string(dbg::Edge &)> &labeler,
+                     size_t threads = 1) {
     const std::function<std::string(dbg::Edge &)> colorer = [](dbg::Edge &) {return "black";};
-    printDot(os, component, labeler, colorer);
+    printDot(os, component, labeler, colorer, threads);
 }
 
 inline void printDot(const std::experimental::filesystem::path &f, const dbg::Component &component, const std::function<std::string(dbg::Edge &)> &labeler,
@@ -164,10 +177,11 @@ inline void printDot(const std::experimental::filesystem::path &f, const dbg::Co
     os.close();
 }
 
-inline void printDot(const std::experimental::filesystem::path &f, const dbg::Component &component, const std::function<std::string(dbg::Edge &)> &labeler) {
+inline void printDot(const std::experimental::filesystem::path &f, const dbg::Component &component, const std::function<std::string(dbg::Edge &)> &labeler,
+                     size_t threads = 1) {
     std::ofstream os;
     os.open(f);
-    printDot(os, component, labeler);
+    printDot(os, component, labeler, threads);
     os.close();
 }
 
@@ -118,25 +118,24 @@ std::unordered_map<dbg::Vertex *, size_t> findReachable(dbg::Vertex &start, doub
     return std::move(res);
 }
 
-std::vector<dbg::GraphAlignment>
-FindPlausibleBulgeAlternatives(const dbg::GraphAlignment &path, size_t max_diff, double min_cov) {
-    size_t k = path.start().seq.size();
-    size_t max_len = path.len() + max_diff;
-    std::unordered_map<dbg::Vertex *, size_t> reachable = findReachable(path.finish().rc(), min_cov, max_len);
-    std::vector<dbg::GraphAlignment> res;
-    dbg::GraphAlignment alternative(path.start());
+//Returns false if there are too many alternatives and the search was abandoned
+bool SearchBulgeAlternatives(dbg::Vertex &start, dbg::Vertex &finish, size_t path_len, size_t max_diff, double min_cov,
+                             std::vector<dbg::GraphAlignment> &res) {
+    size_t max_len = path_len + max_diff;
+    std::unordered_map<dbg::Vertex *, size_t> reachable = findReachable(finish.rc(), min_cov, max_len);
+    dbg::GraphAlignment alternative(start);
     size_t iter_cnt = 0;
     size_t len = 0;
     bool forward = true;
     while(true) {
         iter_cnt += 1;
         if(iter_cnt > 10000)
-            return {path};
+            return false;
         if(forward) {
-            if(alternative.finish() == path.finish() && len + max_diff >= path.len()) {
+            if(alternative.finish() == finish && len + max_diff >= path_len) {
                 res.emplace_back(alternative);
                 if(res.size() > 30) {
-                    return {path};
+                    return false;
                 }
             }
             forward = false;
@@ -172,9 +171,56 @@ FindPlausibleBulgeAlternatives(const dbg::GraphAlignment &path, size_t max_diff,
             }
         }
     }
+    return true;
+}
+
+std::vector<dbg::GraphAlignment>
+FindPlausibleBulgeAlternatives(const dbg::GraphAlignment &path, size_t max_diff, double min_cov) {
+    std::vector<dbg::GraphAlignment> res;
+    if(!SearchBulgeAlternatives(path.start(), path.finish(), path.len(), max_diff, min_cov, res))
+        return {path};
     return std::move(res);
 }
 
+BulgeAlternativesCache::BulgeAlternativesCache(size_t shard_num) : shards(shard_num) {
+    for(Shard &shard : shards)
+        omp_init_lock(&shard.lock);
+}
+
+BulgeAlternativesCache::~BulgeAlternativesCache() {
+    for(Shard &shard : shards)
+        omp_destroy_lock(&shard.lock);
+}
+
+std::vector<dbg::GraphAlignment>
+BulgeAlternativesCache::findPlausibleAlternatives(const dbg::GraphAlignment &path, size_t max_diff, double min_cov) {
+    Key key = {&path.start(), &path.finish(), path.len(), max_diff, min_cov};
+    Shard &shard = shards[KeyHash()(key) % shards.size()];
+    omp_set_lock(&shard.lock);
+    auto it = shard.results.find(key);
+    bool found = it != shard.results.end();
+    Result result;
+    if(found)
+        result = it->second;
+    omp_unset_lock(&shard.lock);
+    if(!found) {
+//        Search is done outside of the lock. Concurrent searches for the same key produce identical results.
+        result.complete = SearchBulgeAlternatives(path.start(), path.finish(), path.len(), max_diff, min_cov,
+                                                  result.alternatives);
+        omp_set_lock(&shard.lock);
+        shard.results.emplace(key, result);
+        omp_unset_lock(&shard.lock);
+    }
+    if(!result.complete)
+        return {path};
+    return std::move(result.alternatives);
+}
+
+void BulgeAlternativesCache::clear() {
+    for(Shard &shard : shards)
+        shard.results.clear();
+}
+
 dbg::GraphAlignment FindReliableExtension(dbg::Vertex &start, size_t len, double min_cov) {
     dbg::GraphAlignment res(start);
     size_t clen = 0;
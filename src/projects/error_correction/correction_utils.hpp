@@ -1,11 +1,63 @@
 #pragma once
 #include "dbg/sparse_dbg.hpp"
 #include "dbg/paths.hpp"
+#include <omp.h>
 
 void FillReliableWithConnections(logging::Logger &logger, dbg::SparseDBG &sdbg, double threshold);
 std::unordered_map<dbg::Vertex *, size_t> findReachable(dbg::Vertex &start, double min_cov, size_t max_dist);
 std::vector<dbg::GraphAlignment> FindPlausibleBulgeAlternatives(const dbg::GraphAlignment &path,
                                                                        size_t max_diff, double min_cov);
+
+//Memoizes FindPlausibleBulgeAlternatives during a correction pass. The search depends only on the ends of the bulge,
+//its length and the search parameters, so all reads that pass through the same bulge share a single search.
+//Results depend on edge coverage and reliability, so the cache must be cleared whenever the graph is modified.
+class BulgeAlternativesCache {
+private:
+    struct Key {
+        dbg::Vertex *start;
+        dbg::Vertex *finish;
+        size_t len;
+        size_t max_diff;
+        double min_cov;
+
+        bool operator==(const Key &other) const {
+            return start == other.start && finish == other.finish && len == other.len &&
+                   max_diff == other.max_diff && min_cov == other.min_cov;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            size_t res = std::hash<dbg::Vertex *>()(key.start);
+            res = res * 1000003 ^ std::hash<dbg::Vertex *>()(key.finish);
+            res = res * 1000003 ^ key.len;
+            res = res * 1000003 ^ key.max_diff;
+            return res * 1000003 ^ std::hash<double>()(key.min_cov);
+        }
+    };
+
+    struct Result {
+        bool complete = true;
+        std::vector<dbg::GraphAlignment> alternatives;
+    };
+
+    struct Shard {
+        omp_lock_t lock = {};
+        std::unordered_map<Key, Result, KeyHash> results;
+    };
+
+    std::vector<Shard> shards;
+public:
+    explicit BulgeAlternativesCache(size_t shard_num = 64);
+    BulgeAlternativesCache(const BulgeAlternativesCache &) = delete;
+    BulgeAlternativesCache &operator=(const BulgeAlternativesCache &) = delete;
+    ~BulgeAlternativesCache();
+
+    std::vector<dbg::GraphAlignment> findPlausibleAlternatives(const dbg::GraphAlignment &path,
+                                                               size_t max_diff, double min_cov);
+    void clear();
+};
+
 dbg::GraphAlignment FindReliableExtension(dbg::Vertex &start, size_t len, double min_cov);
 std::vector<dbg::GraphAlignment> FindPlausibleTipAlternatives(const dbg::GraphAlignment &path,
                                                                 size_t max_diff, double min_cov);
\ No newline at end of file
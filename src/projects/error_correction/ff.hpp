@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <queue>
 #include <unordered_map>
 #include <common/verify.hpp>
@@ -36,9 +37,28 @@ private:
         vertices[to].inc.push_back(eid);
         vertices[to].out.push_back(-eid);
         vertices[from].inc.push_back(-eid);
+        arcs_valid = false;
+        components_valid = false;
         return eid;
     }
 
+    //Residual arcs of all vertices in compressed sparse row layout. Rebuilt lazily after new edges are added.
+    std::vector<size_t> arc_offsets;
+    std::vector<int> arcs;
+    bool arcs_valid = false;
+    //Strongly connected components of the residual network. Recomputed lazily after the flow changes.
+    std::vector<size_t> residual_component;
+    bool components_valid = false;
+    //Buffers reused by all flow and cycle searches in this network
+    std::vector<int> level;
+    std::vector<size_t> arc_iter;
+    std::vector<size_t> queue;
+    std::vector<size_t> order;
+    std::vector<size_t> stack;
+    std::vector<int> path;
+    std::vector<size_t> visit_stamp;
+    size_t stamp = 0;
+
 protected:
     std::vector<Vertex> vertices;
     std::vector<Edge> edges;
@@ -118,6 +138,7 @@ private:
         VERIFY(val <= getEdge(edgeId).capacity);
         getEdge(edgeId).capacity -= val;
         getEdge(-edgeId).capacity += val;
+        components_valid = false;
     }
 
     void pushFlow(const std::vector<int> &path, size_t val = 1) {
@@ -141,20 +162,178 @@ private:
         return indeg;
     }
 
+    void buildArcs() {
+        if(arcs_valid)
+            return;
+        arc_offsets.assign(vertices.size() + 1, 0);
+        arcs.clear();
+        for(Vertex &v : vertices) {
+            arcs.insert(arcs.end(), v.out.begin(), v.out.end());
+            arc_offsets[v.id + 1] = arcs.size();
+        }
+        arcs_valid = true;
+    }
+
+    size_t nextStamp() {
+        visit_stamp.resize(vertices.size(), 0);
+        return ++stamp;
+    }
+
+    //Breadth-first distances from source in the residual network. Returns false if sink is not reachable.
+    bool buildLevels() {
+        level.assign(vertices.size(), -1);
+        queue.clear();
+        level[source] = 0;
+        queue.push_back(source);
+        for(size_t i = 0; i < queue.size(); i++) {
+            size_t v = queue[i];
+            for(size_t j = arc_offsets[v]; j < arc_offsets[v + 1]; j++) {
+                const Edge &edge = getEdge(arcs[j]);
+                if(edge.capacity > 0 && level[edge.end] < 0) {
+                    level[edge.end] = level[v] + 1;
+                    queue.push_back(edge.end);
+                }
+            }
+        }
+        return level[sink] >= 0;
+    }
+
+    //Pushes up to limit units of flow along shortest residual paths (Dinic blocking flow).
+    //Paths are extended iteratively so that long paths in large components do not exhaust the stack.
+    size_t blockingFlow(size_t limit) {
+        arc_iter.assign(arc_offsets.begin(), arc_offsets.end() - 1);
+        path.clear();
+        size_t total = 0;
+        size_t v = source;
+        while(total < limit) {
+            if(v == sink) {
+                size_t val = limit - total;
+                for(int eid : path)
+                    val = std::min(val, getEdge(eid).capacity);
+                pushFlow(path, val);
+                total += val;
+                path.clear();
+                v = source;
+                continue;
+            }
+            bool advanced = false;
+            for(; arc_iter[v] < arc_offsets[v + 1]; arc_iter[v]++) {
+                int eid = arcs[arc_iter[v]];
+                const Edge &edge = getEdge(eid);
+                if(edge.capacity > 0 && level[edge.end] == level[v] + 1) {
+                    path.push_back(eid);
+                    v = edge.end;
+                    advanced = true;
+                    break;
+                }
+            }
+            if(advanced)
+                continue;
+            level[v] = -1;
+            if(path.empty())
+                break;
+            v = getEdge(path.back()).start;
+            path.pop_back();
+            arc_iter[v]++;
+        }
+        return total;
+    }
+
+    //Kosaraju algorithm over residual arcs. Incoming residual arcs of a vertex are reverses of its outgoing arcs.
+    void buildResidualComponents() {
+        if(components_valid)
+            return;
+        buildArcs();
+        size_t n = vertices.size();
+        size_t cur = nextStamp();
+        order.clear();
+        arc_iter.assign(arc_offsets.begin(), arc_offsets.end() - 1);
+        for(size_t start = 0; start < n; start++) {
+            if(visit_stamp[start] == cur)
+                continue;
+            visit_stamp[start] = cur;
+            stack.push_back(start);
+            while(!stack.empty()) {
+                size_t v = stack.back();
+                if(arc_iter[v] < arc_offsets[v + 1]) {
+                    const Edge &edge = getEdge(arcs[arc_iter[v]++]);
+                    if(edge.capacity > 0 && visit_stamp[edge.end] != cur) {
+                        visit_stamp[edge.end] = cur;
+                        stack.push_back(edge.end);
+                    }
+                } else {
+                    order.push_back(v);
+                    stack.pop_back();
+                }
+            }
+        }
+        residual_component.assign(n, n);
+        for(size_t i = n; i > 0; i--) {
+            size_t root = order[i - 1];
+            if(residual_component[root] != n)
+                continue;
+            residual_component[root] = root;
+            stack.push_back(root);
+            while(!stack.empty()) {
+                size_t v = stack.back();
+                stack.pop_back();
+                for(size_t j = arc_offsets[v]; j < arc_offsets[v + 1]; j++) {
+                    const Edge &back = getEdge(-arcs[j]);
+                    if(back.capacity > 0 && residual_component[back.start] == n) {
+                        residual_component[back.start] = root;
+                        stack.push_back(back.start);
+                    }
+                }
+            }
+        }
+        components_valid = true;
+    }
+
+    //Checks if there is a residual path from one vertex to another that does not use the given arc.
+    //Such a path can only pass through the strongly connected component that contains both vertices.
+    bool reachable(size_t from, size_t to, int avoidEdge) {
+        size_t cur = nextStamp();
+        size_t component = residual_component[from];
+        queue.clear();
+        queue.push_back(from);
+        visit_stamp[from] = cur;
+        for(size_t i = 0; i < queue.size(); i++) {
+            size_t v = queue[i];
+            if(v == to)
+                return true;
+            for(size_t j = arc_offsets[v]; j < arc_offsets[v + 1]; j++) {
+                const Edge &edge = getEdge(arcs[j]);
+                if(edge.id != avoidEdge && edge.capacity > 0 && visit_stamp[edge.end] != cur &&
+                            residual_component[edge.end] == component) {
+                    visit_stamp[edge.end] = cur;
+                    queue.push_back(edge.end);
+                }
+            }
+        }
+        return false;
+    }
+
 public:
     bool fillNetwork() {
-        size_t outdeg = outCapasity(source);
-        for(size_t i = 0; i < outdeg; i++) {
-            std::vector<int> path = bfs(source, sink);
-            if(path.empty())
-                return false;
-            pushFlow(path, 1);
+        buildArcs();
+        size_t required = outCapasity(source);
+        size_t total = 0;
+        while(total < required && buildLevels()) {
+            total += blockingFlow(required - total);
         }
-        return true;
+        return total == required;
     }
 
     bool isInLoop(int edgeId) {
-        return getEdge(edgeId).capacity > 0 && !findLoop(edgeId).empty();
+        const Edge &edge = getEdge(edgeId);
+        if(edge.capacity == 0 || edge.start == edge.end)
+            return false;
+        buildResidualComponents();
+        if(residual_component[edge.start] != residual_component[edge.end])
+            return false;
+        if(getEdge(-edgeId).capacity == 0)
+            return true;
+        return reachable(edge.end, edge.start, -edgeId);
     }
 
     std::vector<int> findLoop(int edgeId) {
@@ -272,7 +272,9 @@ size_t correctLowCoveredRegions(logging::Logger &logger, SparseDBG &sdbg, Record
     logger.info() << "Correcting low covered regions in reads" << std::endl;
     omp_set_num_threads(threads);
     size_t max_size = std::min(reads_storage.getMaxLen() * 9 / 10, std::max<size_t>(k * 2, 1000));
-#pragma omp parallel for default(none) schedule(dynamic, 100) shared(std::cout, reads_storage, ref_storage, results, threshold, k, max_size, logger, simple_bulge_cnt, bulge_cnt, dump, reliable_threshold)
+//    Corrections are only applied after all reads are processed so the graph does not change while the cache is alive
+    BulgeAlternativesCache bulge_alternatives;
+#pragma omp parallel for default(none) schedule(dynamic, 100) shared(std::cout, reads_storage, ref_storage, results, threshold, k, max_size, logger, simple_bulge_cnt, bulge_cnt, dump, reliable_threshold, bulge_alternatives)
     for(size_t read_ind = 0; read_ind < reads_storage.size(); read_ind++) {
         std::stringstream ss;
         std::vector<std::string> messages;
@@ -406,7 +408,7 @@ size_t correctLowCoveredRegions(logging::Logger &logger, SparseDBG &sdbg, Record
                     read_alternatives = reads_storage.getRecord(badPath.start()).getBulgeAlternatives(badPath.finish(), threshold);
                 if(read_alternatives.empty()) {
                     new_message = "bp";
-                    read_alternatives = FindPlausibleBulgeAlternatives(badPath,
+                    read_alternatives = bulge_alternatives.findPlausibleAlternatives(badPath,
                                                                        std::max<size_t>(size * 3 / 100, 100), 3);
                 }
                 GraphAlignment substitution = chooseBulgeCandidate(logger, ss, badPath, reads_storage, ref_storage, threshold,
@@ -321,7 +321,7 @@ GraphAlignment ManyKCorrector::correctBulgeAsDoubleTip(const ManyKCorrector::Bul
 
 GraphAlignment ManyKCorrector::correctBulgeWithReliable(const ManyKCorrector::Bulge &bulge) const {
     size_t blen = bulge.bulge.len();
-    std::vector<dbg::GraphAlignment> alternatives = FindPlausibleBulgeAlternatives(bulge.bulge, std::max<size_t>(blen / 100, 20), 3);
+    std::vector<dbg::GraphAlignment> alternatives = bulge_alternatives.findPlausibleAlternatives(bulge.bulge, std::max<size_t>(blen / 100, 20), 3);
     if(alternatives.size() == 1)
         return alternatives[0];
     else
@@ -350,18 +350,18 @@ GraphAlignment ManyKCorrector::ReadRecord::getBlock(size_t num) const {
 
 size_t ManyKCorrect(logging::Logger &logger, SparseDBG &dbg, RecordStorage &reads_storage, double threshold,
                     double reliable_threshold, size_t K, size_t expectedCoverage, size_t threads) {
+    //RemoveUncovered builds a new graph between rounds, so reliable edges can not be carried over from the previous round
     FillReliableWithConnections(logger, dbg, reliable_threshold);
     logger.info() << "Correcting low covered regions in reads with K = " << K << std::endl;
     ManyKCorrector corrector(dbg, reads_storage, K, expectedCoverage, reliable_threshold, threshold);
     ParallelCounter cnt(threads);
-    omp_set_num_threads(threads);
-#pragma omp parallel for default(none) schedule(dynamic, 100) shared(std::cout, corrector, reads_storage, threshold, logger, reliable_threshold, cnt)
-    for(size_t read_ind = 0; read_ind < reads_storage.size(); read_ind++) {
-        std::stringstream ss;
-        std::vector<std::string> messages;
+    std::function<size_t(size_t)> read_cost = [&reads_storage](size_t read_ind) {
+        return reads_storage[read_ind].path.size();
+    };
+    std::function<void(size_t)> task = [&corrector, &reads_storage, &cnt](size_t read_ind) {
         AlignedRead &alignedRead = reads_storage[read_ind];
         if (!alignedRead.valid())
-            continue;
+            return;
         CompactPath &initial_cpath = alignedRead.path;
         std::string message;
         GraphAlignment corrected = corrector.correctRead(initial_cpath.getAlignment(), message);
@@ -369,7 +369,8 @@ size_t ManyKCorrect(logging::Logger &logger, SparseDBG &dbg, RecordStorage &read
             reads_storage.reroute(alignedRead, corrected, message);
             cnt += 1;
         }
-    }
+    };
+    processByCost(threads, reads_storage.size(), read_cost, task);
     reads_storage.applyCorrections(logger, threads);
     logger.info() << "Corrected low covered regions in " << cnt.get() << " reads with K = " << K << std::endl;
     return cnt.get();
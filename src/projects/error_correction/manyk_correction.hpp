@@ -1,6 +1,7 @@
 #pragma once
 #include "dbg/graph_alignment_storage.hpp"
 #include "dbg/sparse_dbg.hpp"
+#include "correction_utils.hpp"
 
 class ManyKCorrector {
 private:
@@ -49,6 +50,8 @@ private:
     size_t expected_coverage;
     double reliable_threshold;
     double bad_threshold;
+//    Graph is not modified while corrector is alive. Corrections are applied to reads storage afterwards.
+    mutable BulgeAlternativesCache bulge_alternatives;
 public:
     ManyKCorrector(dbg::SparseDBG &dbg, RecordStorage &reads, size_t K, size_t expectedCoverage,
                    double reliable_threshold, double bad_threshold) :
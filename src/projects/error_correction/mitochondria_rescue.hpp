@@ -1,12 +1,13 @@
 #pragma once
 #include "dbg/sparse_dbg.hpp"
 #include "dbg/graph_alignment_storage.hpp"
+#include "dbg/component.hpp"
 
-inline bool CheckCov(const dbg::Component &component, double &d) {
+inline bool CheckCov(const std::vector<dbg::Edge *> &edges, double &d) {
     size_t bad_cnt = 0;
     size_t good_cnt = 0;
-    for(dbg::Edge &edge :component.edgesUnique()) {
-        if(edge.getCoverage() <= d)
+    for(dbg::Edge *edge : edges) {
+        if(edge->getCoverage() <= d)
             bad_cnt++;
         else
             good_cnt++;
@@ -18,41 +19,65 @@ inline bool CheckCov(const dbg::Component &component, double &d) {
 inline void MRescue(logging::Logger &logger, size_t threads, dbg::SparseDBG &dbg,
                     RecordStorage &reads_storage, size_t unique_length, double error_fraction = 0.05) {
     logger.info() << "Attempting to rescue small circular highly covered components" << std::endl;
-    std::unordered_set<dbg::Edge const *> bad_edges;
-    size_t cnt = 0;
-    for(const dbg::Component &component : dbg::CCSplitter().splitGraph(dbg)) {
-        if(component.size() > 100)
+    dbg::ComponentLabeling components(dbg, threads);
+//    Coverage threshold below which edges of the component are removed or -1 if component was not rescued
+    std::vector<double> thresholds(components.size(), -1);
+    std::vector<size_t> sizes(components.size(), 0);
+    omp_set_num_threads(threads);
+#pragma omp parallel for default(none) schedule(dynamic, 100) shared(components, thresholds, sizes, unique_length, error_fraction)
+    for(size_t comp = 0; comp < components.size(); comp++) {
+        if(components.componentSize(comp) > 100)
             continue;
+        std::vector<dbg::Edge *> edges;
+        for(dbg::Vertex *vertex : components.componentVertices(comp)) {
+            for(dbg::Vertex *vp : {vertex, &vertex->rc()}) {
+                for(dbg::Edge &edge : *vp) {
+                    if(edge <= edge.rc())
+                        edges.emplace_back(&edge);
+                }
+            }
+        }
         bool ok = true;
         std::vector<double> covs;
-        for(dbg::Edge &edge : component.edgesUnique()) {
-            if(edge.size() > unique_length) {
+        for(dbg::Edge *edge : edges) {
+            if(edge->size() > unique_length) {
                 ok = false;
                 break;
             }
-            covs.emplace_back(edge.getCoverage());
+            covs.emplace_back(edge->getCoverage());
         }
         if(!ok)
             continue;
         std::sort(covs.begin(), covs.end());
         for(size_t i = 0; i + 1 < covs.size(); i++) {
             if(covs[i] < covs[i + 1] * error_fraction) {
-                if(CheckCov(component, covs[i])) {
-                    size_t sz = 0;
-                    for(dbg::Edge &edge :component.edges()) {
-                        if(edge.getCoverage() <= covs[i]) {
-                            bad_edges.emplace(&edge);
-                        } else {
-                            sz += edge.size();
-                        }
+                if(CheckCov(edges, covs[i])) {
+                    thresholds[comp] = covs[i];
+                    for(dbg::Edge *edge : edges) {
+                        if(edge->getCoverage() > covs[i])
+                            sizes[comp] += edge->size();
                     }
-                    logger.trace() << "Rescued component of size " << (sz / 2) << std::endl;
-                    cnt++;
                     break;
                 }
             }
         }
     }
+    std::unordered_set<dbg::Edge const *> bad_edges;
+    size_t cnt = 0;
+    for(size_t comp = 0; comp < components.size(); comp++) {
+        if(thresholds[comp] < 0)
+            continue;
+        for(dbg::Vertex *vertex : components.componentVertices(comp)) {
+            for(dbg::Vertex *vp : {vertex, &vertex->rc()}) {
+                for(dbg::Edge &edge : *vp) {
+                    if(edge.getCoverage() <= thresholds[comp])
+                        bad_edges.emplace(&edge);
+                }
+            }
+        }
+        logger.trace() << "Rescued component of size " << sizes[comp] << std::endl;
+        cnt++;
+    }
     std::function<bool(const dbg::Edge&)> is_bad = [&bad_edges](const dbg::Edge &edge) {
         return bad_edges.find(&edge) != bad_edges.end();
     };
@@ -257,13 +257,14 @@ GraphAlignment correctRead(std::unordered_map<const Edge *, CompactPath> &unique
 
 void correctReads(logging::Logger &logger, size_t threads, RecordStorage &reads_storage,
                   std::unordered_map<const Edge *, CompactPath> &unique_extensions) {
-    omp_set_num_threads(threads);
     logger.info() << "Correcting reads using unique edge extensions" << std::endl;
-#pragma omp parallel for default(none) schedule(dynamic, 100) shared(reads_storage, unique_extensions)
-    for(size_t i = 0; i < reads_storage.size(); i++) {
+    std::function<size_t(size_t)> read_cost = [&reads_storage](size_t i) {
+        return reads_storage[i].path.size();
+    };
+    std::function<void(size_t)> task = [&reads_storage, &unique_extensions](size_t i) {
         AlignedRead &alignedRead = reads_storage[i];
         if(!alignedRead.valid())
-            continue;
+            return;
         const GraphAlignment al = alignedRead.path.getAlignment();
         if(al.size() > 1) {
             GraphAlignment corrected1 = correctRead(unique_extensions, al);
@@ -272,7 +273,8 @@ void correctReads(logging::Logger &logger, size_t threads, RecordStorage &reads_
                 reads_storage.reroute(alignedRead, al, corrected2, "mult correction");
             }
         }
-    }
+    };
+    processByCost(threads, reads_storage.size(), read_cost, task);
     reads_storage.applyCorrections(logger, threads);
 }
 
@@ -364,7 +366,7 @@ RecordStorage MultCorrect(SparseDBG &dbg, logging::Logger &logger, const std::ex
         recreate_dir(dump_dir);
     }
     UniqueClassificator classificator(dbg, reads_storage, diploid, debug);
-    classificator.classify(logger, unique_threshold, multiplicity_figures/"ongoing");
+    classificator.classify(logger, threads, unique_threshold, multiplicity_figures/"ongoing");
     if(debug)
         DrawMult(multiplicity_figures / "round1", dbg, unique_threshold, reads_storage, classificator);
     CorrectBasedOnUnique(logger, threads, dbg, reads_storage, classificator, dump_dir/"round1.txt");
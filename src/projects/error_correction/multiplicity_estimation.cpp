@@ -1,6 +1,8 @@
 #include <common/simple_computation.hpp>
 #include "diploidy_analysis.hpp"
 #include "multiplicity_estimation.hpp"
+#include <algorithm>
+#include <numeric>
 using namespace dbg;
 size_t BoundRecord::inf = 1000000000000ul;
 
@@ -152,7 +154,7 @@ void UniqueClassificator::markPseudoHets() const {
     }
 }
 
-void UniqueClassificator::classify(logging::Logger &logger, size_t unique_len,
+void UniqueClassificator::classify(logging::Logger &logger, size_t threads, size_t unique_len,
                                    const std::experimental::filesystem::path &dir) {
     logger.info() << "Looking for unique edges" << std::endl;
     if(debug)
@@ -212,26 +214,44 @@ void UniqueClassificator::classify(logging::Logger &logger, size_t unique_len,
     logger.trace() << "Marking bulges to collapse" << std::endl;
     markPseudoHets();
     logger.info() << "Splitting graph with unique edges" << std::endl;
-    std::vector<Component> split = UniqueSplitter(*this).split(Component(dbg));
+    std::vector<Component> split = UniqueSplitter(*this, threads).split(Component(dbg));
     logger.info() << "Processing " << split.size() << " components" << std::endl;
-    size_t component_cnt = 0;
-    for(Component &component : split) {
-        component_cnt += 1;
+//    Components do not share inner edges, so they are processed in parallel with copies of multiplicity bounds.
+//    Large components are started first. Bounds and logs are merged in the original order of components.
+    std::vector<size_t> order(split.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&split](size_t a, size_t b) {
+        return split[a].size() > split[b].size();
+    });
+    std::vector<MultiplicityBounds> component_bounds(split.size());
+    std::vector<std::string> component_logs(split.size());
+    std::vector<size_t> component_ucnt(split.size());
+    omp_set_num_threads(threads);
+#pragma omp parallel for default(none) shared(split, order, component_bounds, component_logs, component_ucnt, logger, dir) schedule(dynamic, 1)
+    for(size_t i = 0; i < order.size(); i++) {
+        size_t num = order[i];
+        Component &component = split[num];
+        logging::Logger component_logger(logger, component_logs[num]);
         if(debug)
-            printDot(dir / (std::to_string(component_cnt) + ".dot"), component, reads_storage.labeler());
-        //TODO make parallel trace
-        logger.trace() << "Component parameters: size=" << component.size() << " border=" << component.countBorderEdges() <<
+            printDot(dir / (std::to_string(num + 1) + ".dot"), component, reads_storage.labeler());
+        component_logger.trace() << "Component parameters: size=" << component.size() << " border=" << component.countBorderEdges() <<
                       " tips=" << component.countTips() <<
                       " subcomponents=" << component.realCC() << " acyclic=" << component.isAcyclic() <<std::endl;
         if(component.size() > 2 && component.countBorderEdges() == 2 &&component.countTips() == 0 &&
            component.realCC() == 2 && component.isAcyclic()) {
-            processSimpleComponent(logger, component);
+            processSimpleComponent(component_logger, component);
         }
-        cnt += processComponent(logger, component);
+        component_bounds[num] = MultiplicityBounds(component, *this);
+        component_ucnt[num] = processComponent(component_logger, component_bounds[num], component);
+    }
+    for(size_t num = 0; num < split.size(); num++) {
+        logger.append(component_logs[num]);
+        updateBounds(component_bounds[num]);
+        cnt += component_ucnt[num];
         if(debug)
-            logger.trace() << "Printing component to " << (dir / (std::to_string(component_cnt) + ".dot")) << std::endl;
+            logger.trace() << "Printing component to " << (dir / (std::to_string(num + 1) + ".dot")) << std::endl;
         if(debug)
-            printDot(dir / (std::to_string(component_cnt) + ".dot"), component,
+            printDot(dir / (std::to_string(num + 1) + ".dot"), split[num],
                      this->labeler() + reads_storage.labeler(), this->colorer());
     }
     logger.info() << "Finished unique edges search. Found " << cnt << " unique edges" << std::endl;
@@ -239,7 +259,7 @@ void UniqueClassificator::classify(logging::Logger &logger, size_t unique_len,
     std::function<bool(const dbg::Edge &)> mult2 = [this](const dbg::Edge &edge) {
         return MultiplicityBounds::lowerBound(edge) == 2 && MultiplicityBounds::lowerBound(edge) == 2;
     };
-    split = ConditionSplitter(mult2).splitGraph(dbg);
+    split = ConditionSplitter(mult2, threads).splitGraph(dbg);
     cnt = 0;
     for(Component &component : split) {
         if(component.size() != 4 || !component.isAcyclic() || component.realCC() != 2 || component.borderVertices().size() != 2) {
@@ -322,10 +342,10 @@ bool UniqueClassificator::processSimpleRepeat(const Component &component) {
     return true;
 }
 
-size_t UniqueClassificator::ProcessUsingCoverage(logging::Logger &logger,
+size_t UniqueClassificator::ProcessUsingCoverage(logging::Logger &logger, MultiplicityBounds &bounds,
                                           const Component &subcomponent,
                                           const std::function<bool(const dbg::Edge &)> &is_unique,
-                                          double rel_coverage) {
+                                          double rel_coverage) const {
     size_t ucnt = 0;
     std::pair<double, double> tmp = minmaxCov(subcomponent, reads_storage, is_unique);
     double min_cov = tmp.first;
@@ -345,10 +365,10 @@ size_t UniqueClassificator::ProcessUsingCoverage(logging::Logger &logger,
     if (res) {
         logger.trace() << "Succeeded to use coverage for multiplicity estimation" << std::endl;
         for(auto rec : net2.findBounds()) {
-            if(!MultiplicityBounds::isUnique(*rec.first) && rec.second.first == 1 && rec.second.second == 1) {
+            if(!bounds.isUnique(*rec.first) && rec.second.first == 1 && rec.second.second == 1) {
                 ucnt++;
             }
-            updateBounds(*rec.first, rec.second.first, rec.second.second);
+            bounds.updateBounds(*rec.first, rec.second.first, rec.second.second);
         }
     } else {
         logger.trace() << "Failed to use coverage for multiplicity estimation" << std::endl;
@@ -362,10 +382,10 @@ size_t UniqueClassificator::ProcessUsingCoverage(logging::Logger &logger,
         if (res) {
             logger.trace() << "Succeeded to use coverage for multiplicity estimation" << std::endl;
             for(auto rec : net3.findBounds()) {
-                if(!MultiplicityBounds::isUnique(*rec.first) && rec.second.first == 1 && rec.second.second == 1) {
+                if(!bounds.isUnique(*rec.first) && rec.second.first == 1 && rec.second.second == 1) {
                     ucnt++;
                 }
-                updateBounds(*rec.first, rec.second.first, rec.second.second);
+                bounds.updateBounds(*rec.first, rec.second.first, rec.second.second);
             }
         } else {
             logger.trace() << "Failed to use adjusted reliable coverage for multiplicity estimation" << std::endl;
@@ -379,10 +399,10 @@ size_t UniqueClassificator::ProcessUsingCoverage(logging::Logger &logger,
         if (res) {
             logger.trace() << "Succeeded to use coverage for multiplicity estimation" << std::endl;
             for(auto rec : net4.findBounds()) {
-                if(!MultiplicityBounds::isUnique(*rec.first) && rec.second.first == 1 && rec.second.second == 1) {
+                if(!bounds.isUnique(*rec.first) && rec.second.first == 1 && rec.second.second == 1) {
                     ucnt++;
                 }
-                updateBounds(*rec.first, rec.second.first, rec.second.second);
+                bounds.updateBounds(*rec.first, rec.second.first, rec.second.second);
             }
         } else {
             logger.trace() << "Failed to use coverage for multiplicity estimation" << std::endl;
@@ -395,10 +415,10 @@ size_t UniqueClassificator::ProcessUsingCoverage(logging::Logger &logger,
     res = net5.fillNetwork();
     if(res) {
         for(auto rec : net5.findBounds()) {
-            if(!MultiplicityBounds::isUnique(*rec.first) && rec.second.first == 1 && rec.second.second == 1) {
+            if(!bounds.isUnique(*rec.first) && rec.second.first == 1 && rec.second.second == 1) {
                 ucnt++;
             }
-            updateBounds(*rec.first, rec.second.first, rec.second.second);
+            bounds.updateBounds(*rec.first, rec.second.first, rec.second.second);
         }
     } else {
         double_threshold = 0;
@@ -510,7 +530,8 @@ void UniqueClassificator::processSimpleComponent(logging::Logger &logger, const
     }
 }
 
-size_t UniqueClassificator::processComponent(logging::Logger &logger, const Component &component) {
+size_t UniqueClassificator::processComponent(logging::Logger &logger, MultiplicityBounds &bounds,
+                                             const Component &component) const {
     size_t ucnt = 0;
     logger.trace() << "Component: ";
     for(Vertex &vertex : component.verticesUnique()) {
@@ -518,15 +539,15 @@ size_t UniqueClassificator::processComponent(logging::Logger &logger, const Comp
     }
     logger << std::endl;
     double rel_coverage = 0;
-    std::function<bool(const dbg::Edge &)> is_unique = [this](const dbg::Edge &edge) {
-        return isUnique(edge);
+    std::function<bool(const dbg::Edge &)> is_unique = [&bounds](const dbg::Edge &edge) {
+        return bounds.isUnique(edge);
     };
     MappedNetwork net(component, is_unique, rel_coverage);
     bool res = net.fillNetwork();
     if(res) {
         logger.trace() << "Found unique edges in component" << std::endl;
         for(Edge * edge : net.getUnique(logger)) {
-            updateBounds(*edge, 1, 1);
+            bounds.updateBounds(*edge, 1, 1);
             ucnt++;
         }
     } else {
@@ -538,7 +559,7 @@ size_t UniqueClassificator::processComponent(logging::Logger &logger, const Comp
         if(res) {
             logger.trace() << "Found unique edges in component" << std::endl;
             for(Edge * edge : net1.getUnique(logger)) {
-                updateBounds(*edge, 1, 1);
+                bounds.updateBounds(*edge, 1, 1);
                 ucnt++;
             }
         } else {
@@ -546,10 +567,10 @@ size_t UniqueClassificator::processComponent(logging::Logger &logger, const Comp
         }
     }
     if(res) {
-        std::vector<Component> subsplit = ConditionSplitter(this->asFunction()).split(component);
+        std::vector<Component> subsplit = ConditionSplitter(bounds.asFunction()).split(component);
         logger.trace() << "Component was split into " << subsplit.size() << " subcompenents" << std::endl;
         for(Component &subcomponent : subsplit) {
-            ucnt += ProcessUsingCoverage(logger, subcomponent, this->asFunction(), rel_coverage);
+            ucnt += ProcessUsingCoverage(logger, bounds, subcomponent, bounds.asFunction(), rel_coverage);
         }
     }
     return ucnt;
@@ -585,7 +606,7 @@ std::pair<Edge *, Edge *> CheckLoopComponent(const Component &component) {
 RecordStorage ResolveLoops(logging::Logger &logger, size_t threads, SparseDBG &dbg, RecordStorage &reads_storage,
                            const AbstractUniquenessStorage &more_unique) {
     RecordStorage res(dbg, 0, 10000000000ull, threads, reads_storage.getLogger(), false, reads_storage.log_changes);
-    for(const Component &comp : UniqueSplitter(more_unique).splitGraph(dbg)) {
+    for(const Component &comp : UniqueSplitter(more_unique, threads).splitGraph(dbg)) {
         std::pair<Edge *, Edge *> check = CheckLoopComponent(comp);
         if(check.first == nullptr)
             continue;
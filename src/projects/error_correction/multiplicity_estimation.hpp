@@ -54,14 +54,14 @@ public:
 
     void markPseudoHets() const;
 
-    void classify(logging::Logger &logger, size_t unique_len, const std::experimental::filesystem::path &dir);
+    void classify(logging::Logger &logger, size_t threads, size_t unique_len, const std::experimental::filesystem::path &dir);
     explicit UniqueClassificator(dbg::SparseDBG &dbg, const RecordStorage &reads_storage, bool diploid, bool debug) :
                     dbg(dbg), reads_storage(reads_storage), diploid(diploid), debug(debug) {}
-    size_t ProcessUsingCoverage(logging::Logger &logger, const dbg::Component &subcomponent,
-                              const std::function<bool(const dbg::Edge &)> &is_unique, double rel_coverage);
+    size_t ProcessUsingCoverage(logging::Logger &logger, MultiplicityBounds &bounds, const dbg::Component &subcomponent,
+                              const std::function<bool(const dbg::Edge &)> &is_unique, double rel_coverage) const;
     void processSimpleComponent(logging::Logger &logger, const dbg::Component &component) const;
     bool processSimpleRepeat(const dbg::Component &component);
-    size_t processComponent(logging::Logger &logger, const dbg::Component &component);
+    size_t processComponent(logging::Logger &logger, MultiplicityBounds &bounds, const dbg::Component &component) const;
 };
 
 RecordStorage ResolveLoops(logging::Logger &logger, size_t threads, dbg::SparseDBG &dbg, RecordStorage &reads_storage,
@@ -60,17 +60,16 @@ size_t Precorrect(logging::Logger &logger, size_t threads, dbg::SparseDBG &dbg,
     logger.info() << "Precorrecting reads" << std::endl;
     ParallelRecordCollector<std::string> results(threads);
     ParallelCounter cnt(threads);
-    omp_set_num_threads(threads);
-#pragma omp parallel for default(none) schedule(dynamic, 100) shared(std::cout, reads_storage, results, logger, reliable_threshold, cnt)
-    for(size_t read_ind = 0; read_ind < reads_storage.size(); read_ind++) {
-        std::stringstream ss;
-        std::vector<std::string> messages;
+    std::function<size_t(size_t)> read_cost = [&reads_storage](size_t read_ind) {
+        return reads_storage[read_ind].path.size();
+    };
+    std::function<void(size_t)> task = [&reads_storage, reliable_threshold, &cnt](size_t read_ind) {
         AlignedRead &alignedRead = reads_storage[read_ind];
         if (!alignedRead.valid())
-            continue;
+            return;
         dbg::GraphAlignment initial_path = alignedRead.path.getAlignment();
         if(initial_path.size() == 1)
-            continue;
+            return;
         dbg::GraphAlignment corrected_path;
         size_t ncor = 0;
         for(size_t i = 0; i < initial_path.size(); i++) {
@@ -96,7 +95,8 @@ size_t Precorrect(logging::Logger &logger, size_t threads, dbg::SparseDBG &dbg,
             reads_storage.reroute(alignedRead, corrected_path, "Precorrection_" + itos(ncor));
             cnt += 1;
         }
-    }
+    };
+    processByCost(threads, reads_storage.size(), read_cost, task);
     reads_storage.applyCorrections(logger, threads);
     logger.info() << "Corrected simple errors in " << cnt.get() << " reads" << std::endl;
     return cnt.get();
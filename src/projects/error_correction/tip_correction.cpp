@@ -4,31 +4,58 @@
 using namespace dbg;
 void MakeUnreliable(Edge &e) {
     e.is_reliable = false;
-    for(Edge &edge : *e.end()) {
-        if(edge.is_reliable) {
-            edge.is_reliable = false;
-            MakeUnreliable(edge);
+    std::vector<Edge *> stack = {&e};
+    while(!stack.empty()) {
+        Edge &next = *stack.back();
+        stack.pop_back();
+        for(Edge &edge : *next.end()) {
+            if(edge.is_reliable) {
+                edge.is_reliable = false;
+                stack.push_back(&edge);
+            }
         }
     }
 }
 
-inline void FillReliableTips(logging::Logger &logger, dbg::SparseDBG &sdbg, double reliable_threshold) {
+inline void FillReliableTips(logging::Logger &logger, dbg::SparseDBG &sdbg, double reliable_threshold, size_t threads) {
     logger.info() << "Remarking reliable edges" << std::endl;
-    for(auto &vit : sdbg) {
-        for(Vertex * vp : {&vit.second, &vit.second.rc()}) {
-            Vertex &v = *vp;
-            for(Edge &edge : v) {
+//    Marks are reset and tip candidates are found in parallel. Bit i of the flag is set if i-th edge of the vertex
+//    in the order of sdbg.edges() is a tip. Tips are then queued in the same order as in a serial scan since the result
+//    of propagation below depends on the order in which tips are processed.
+    std::vector<unsigned char> tip_flags(sdbg.size());
+    std::function<void(size_t, std::pair<const hashing::htype, Vertex> &)> task =
+            [&tip_flags, reliable_threshold](size_t num, std::pair<const hashing::htype, Vertex> &vertex) {
+        unsigned char flags = 0;
+        size_t cur = 0;
+        for(Vertex * vp : {&vertex.second, &vertex.second.rc()}) {
+            for(Edge &edge : *vp) {
                 edge.is_reliable = true;
+                if(edge.end()->outDeg() == 0 && edge.end()->inDeg() == 1 && edge.size() < 10000 && edge.getCoverage() < reliable_threshold)
+                    flags |= 1u << cur;
+                cur++;
             }
         }
-    }
+        tip_flags[num] = flags;
+    };
+    processObjects(sdbg.begin(), sdbg.end(), logger, threads, task);
     size_t infty = 1000000000;
     std::unordered_map<Vertex *, size_t> max_tip;
     std::vector<Edge*> queue;
-    for(Edge &edge : sdbg.edges()) {
-        if(edge.end()->outDeg() == 0 && edge.end()->inDeg() == 1 && edge.size() < 10000 && edge.getCoverage() < reliable_threshold) {
-            max_tip[edge.end()] = 0;
-            queue.emplace_back(&edge);
+    size_t num = 0;
+    for(auto &vit : sdbg) {
+        unsigned char flags = tip_flags[num];
+        num++;
+        if(flags == 0)
+            continue;
+        size_t cur = 0;
+        for(Vertex * vp : {&vit.second, &vit.second.rc()}) {
+            for(Edge &edge : *vp) {
+                if((flags >> cur) & 1u) {
+                    max_tip[edge.end()] = 0;
+                    queue.emplace_back(&edge);
+                }
+                cur++;
+            }
         }
     }
     while(!queue.empty()) {
@@ -137,6 +164,6 @@ void CorrectTips(logging::Logger &logger, size_t threads, SparseDBG &dbg,
 
 void TipCorrectionPipeline(logging::Logger &logger, dbg::SparseDBG &dbg, RecordStorage &reads, size_t threads,
                            double reliable_threshold) {
-    FillReliableTips(logger, dbg, reliable_threshold);
+    FillReliableTips(logger, dbg, reliable_threshold, threads);
     CorrectTips(logger, threads, dbg, {&reads});
 }
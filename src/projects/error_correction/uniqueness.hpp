@@ -44,8 +44,8 @@ public:
 
 class UniqueSplitter : public dbg::ConditionSplitter {
 public:
-    explicit UniqueSplitter(const AbstractUniquenessStorage &storage) :
-            ConditionSplitter([&storage](const dbg::Edge& edge){return storage.isUnique(edge);}){
+    explicit UniqueSplitter(const AbstractUniquenessStorage &storage, size_t threads = 1) :
+            ConditionSplitter([&storage](const dbg::Edge& edge){return storage.isUnique(edge);}, threads){
     }
 };
 
@@ -125,6 +125,25 @@ private:
     std::unordered_map<const dbg::Edge *, BoundRecord> multiplicity_bounds;
     size_t inf = 100000;
 public:
+    MultiplicityBounds() = default;
+
+    //Copy of bounds for edges incident to the component. Used to process the component independently of others.
+    MultiplicityBounds(const dbg::Component &component, const MultiplicityBounds &other) {
+        for(dbg::Edge &edge : component.edges()) {
+            for(const dbg::Edge *e : {&edge, &edge.rc()}) {
+                auto it = other.multiplicity_bounds.find(e);
+                if(it != other.multiplicity_bounds.end())
+                    multiplicity_bounds.emplace(e, it->second);
+            }
+        }
+    }
+
+    void updateBounds(const MultiplicityBounds &other) {
+        for(const auto &it : other.multiplicity_bounds) {
+            updateBounds(*it.first, it.second.lowerBound, it.second.upperBound);
+        }
+    }
+
     size_t upperBound(const dbg::Edge &edge) const {
         auto it = multiplicity_bounds.find(&edge);
         if(it == multiplicity_bounds.end())
@@ -336,7 +336,7 @@ int main(int argc, char **argv) {
         RepeatResolver rr(dbg, {&readStorage}, subdatasets_dir, py_path, true);
         logger.info() << "Extracting subdatasets for connected components" << std::endl;
         std::function<bool(const Edge &)> is_unique = [](const Edge &){return false;};
-        std::vector<RepeatResolver::Subdataset> subdatasets = rr.SplitDataset(is_unique);
+        std::vector<RepeatResolver::Subdataset> subdatasets = rr.SplitDataset(is_unique, threads);
 #pragma omp parallel for schedule(dynamic, 1) default(none) shared(subdatasets, logger, rr)
         for(size_t snum = 0; snum < subdatasets.size(); snum++) {
             RepeatResolver::Subdataset &subdataset = subdatasets[snum];
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "dbg/graph_alignment_storage.hpp"
+#include "dbg/visualization.hpp"
+#include "dbg/paths.hpp"
+#include "dbg/component.hpp"
+#include "dbg/sparse_dbg.hpp"
+#include "sequences/seqio.hpp"
+#include "sequences/contigs.hpp"
+#include "common/dir_utils.hpp"
+#include "common/logging.hpp"
+#include "common/verify.hpp"
+#include <condition_variable>
+#include <experimental/filesystem>
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+ * State dumps of intermediate graphs that are only used for debugging of the pipeline.
+ * off: nothing is computed or written
+ * summary: whole graph in dot and fasta formats after every stage
+ * full: additionally read alignments, neighbourhoods of paths, reference alignments and pictures of all components
+ * Only writing to disk is asynchronous. Dot pictures, fasta, alignments and reference alignments are rendered
+ * synchronously on the calling thread, since the next stage modifies the graph and there is no snapshot to render from.
+ * Rendered text is handed to a background thread that writes it to disk while the pipeline proceeds.
+ */
+namespace diagnostics {
+    enum DiagnosticsLevel {
+        off = 0,
+        summary = 1,
+        full = 2
+    };
+
+    inline DiagnosticsLevel ParseLevel(const std::string &name) {
+        if(name == "off")
+            return off;
+        if(name == "summary")
+            return summary;
+        if(name == "full")
+            return full;
+        VERIFY_MSG(false, "Unknown diagnostics level " + name + ". Possible values are off, summary and full");
+        return off;
+    }
+
+    //Writes files in a separate thread. Producer is blocked if too much text is waiting to be written.
+    class AsyncFileWriter {
+    private:
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::pair<std::experimental::filesystem::path, std::string>> queue;
+        size_t pending = 0;
+        size_t max_pending;
+        bool finished = false;
+        std::thread thread;
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(true) {
+                cv.wait(lock, [this] {return finished || !queue.empty();});
+                if(queue.empty())
+                    return;
+                std::pair<std::experimental::filesystem::path, std::string> file = std::move(queue.front());
+                queue.pop_front();
+                lock.unlock();
+                ensure_dir_existance(file.first.parent_path());
+                std::ofstream os;
+                os.open(file.first);
+                os.write(file.second.data(), file.second.size());
+                os.close();
+                lock.lock();
+                pending -= file.second.size();
+                cv.notify_all();
+            }
+        }
+
+    public:
+        explicit AsyncFileWriter(size_t max_pending = size_t(1) << 30) : max_pending(max_pending),
+                                                                         thread([this] {run();}) {
+        }
+
+        AsyncFileWriter(const AsyncFileWriter &) = delete;
+        AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+
+        ~AsyncFileWriter() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                finished = true;
+            }
+            cv.notify_all();
+            thread.join();
+        }
+
+        void write(const std::experimental::filesystem::path &path, std::string &&text) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] {return pending < max_pending;});
+            pending += text.size();
+            queue.emplace_back(path, std::move(text));
+            cv.notify_all();
+        }
+    };
+
+    //Renders dumps on the calling thread, so dumps above off still cost pipeline time. Only file writes are deferred.
+    class StateDumper {
+    private:
+        logging::Logger &logger;
+        DiagnosticsLevel level;
+        std::experimental::filesystem::path dir;
+        std::vector<Contig> &ref;
+        std::vector<Contig> paths;
+        size_t stage_num = 0;
+        std::unique_ptr<AsyncFileWriter> writer;
+
+        void write(const std::experimental::filesystem::path &path, std::ostringstream &os) {
+            writer->write(path, os.str());
+            os.str("");
+        }
+
+    public:
+        StateDumper(logging::Logger &logger, DiagnosticsLevel level, const std::experimental::filesystem::path &dir,
+                    const io::Library &paths_lib, std::vector<Contig> &ref) :
+                        logger(logger), level(level), dir(dir), ref(ref) {
+            if(level == off)
+                return;
+            writer.reset(new AsyncFileWriter());
+            if(level < full)
+                return;
+            for(StringContig sc : io::SeqReader(paths_lib)) {
+                Contig contig = sc.makeContig();
+                if(contig.size() > 100000) {
+                    paths.emplace_back(contig.seq.Subseq(0, 50000), contig.id + "_start");
+                    paths.emplace_back(contig.seq.Subseq(contig.size() - 50000), contig.id + "_end");
+                } else {
+                    paths.emplace_back(std::move(contig));
+                }
+            }
+        }
+
+        bool enabled(DiagnosticsLevel min_level) const {
+            return level >= min_level;
+        }
+
+        void printPaths(const std::string &stage, dbg::SparseDBG &dbg, RecordStorage &readStorage, bool small) {
+            if(!enabled(summary))
+                return;
+            stage_num += 1;
+            std::string stage_name = itos(stage_num) + "_" + stage;
+            logger.info() << "Dumping current state. Stage id: " << stage_name << std::endl;
+            std::ostringstream os;
+            printDot(os, dbg::Component(dbg), readStorage.labeler());
+            write(dir / (stage_name + ".dot"), os);
+            dbg.printFastaOld(os);
+            write(dir / (stage_name + ".fasta"), os);
+            if(!enabled(full))
+                return;
+            readStorage.printFullAlignments(os);
+            write(dir / (stage_name + ".als"), os);
+            GraphAlignmentStorage storage(dbg);
+            for(Contig &contig : paths) {
+                storage.fill(contig);
+            }
+            std::function<std::string(dbg::Edge &)> labeler = readStorage.labeler() + storage.labeler();
+            for(Contig &contig : paths) {
+                dbg::Component comp = small ? dbg::Component::neighbourhood(dbg, contig, dbg.hasher().getK() + 500) :
+                                      dbg::Component::longEdgeNeighbourhood(dbg, contig, 20000);
+                printDot(os, comp, labeler);
+                write(dir / "paths" / contig.getId() / (stage_name + ".dot"), os);
+            }
+            dbg::GraphAligner aligner(dbg);
+            for(Contig &contig : ref) {
+                os << contig.getId() << std::endl;
+                for(const dbg::PerfectAlignment<Contig, dbg::Edge> &al : aligner.carefulAlign(contig)) {
+                    os << al.seg_from << " " << al.seg_to << std::endl;
+                }
+            }
+            write(dir / (stage_name + ".ref"), os);
+        }
+
+        void drawSplit(dbg::SparseDBG &dbg, const std::experimental::filesystem::path &split_dir,
+                       const std::function<std::string(dbg::Edge &)> &labeler, size_t len = 100000) {
+            if(!enabled(full))
+                return;
+            std::vector<dbg::Component> split = dbg::LengthSplitter(len).split(dbg::Component(dbg));
+            std::ostringstream os;
+            for(size_t i = 0; i < split.size(); i++) {
+                printDot(os, split[i], labeler);
+                write(split_dir / (std::to_string(i) + ".dot"), os);
+            }
+        }
+
+        void drawSplit(dbg::SparseDBG &dbg, const std::experimental::filesystem::path &split_dir, size_t len = 100000) {
+            std::function<std::string(dbg::Edge &)> labeler = [](dbg::Edge &){return "";};
+            drawSplit(dbg, split_dir, labeler, len);
+        }
+    };
+}
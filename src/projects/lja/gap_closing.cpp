@@ -157,6 +157,6 @@ void GapColserPipeline(logging::Logger &logger, size_t threads, dbg::SparseDBG &
         }
     }
     CorrectTips(logger, threads, dbg, storges);
-    printStats(logger, dbg);
+    printStats(logger, dbg, threads);
     RemoveUncovered(logger, threads, dbg, storges);
 }
@@ -11,10 +11,13 @@
 #include "error_correction/precorrection.hpp"
 #include "sequences/seqio.hpp"
 #include "dbg/dbg_construction.hpp"
+#include "dbg/checkpoints.hpp"
+#include "diagnostics.hpp"
 #include "common/rolling_hash.hpp"
 #include "common/dir_utils.hpp"
 #include "common/cl_parser.hpp"
 #include "common/logging.hpp"
+#include "common/memory_budget.hpp"
 #include <wait.h>
 #include <error_correction/dimer_correction.hpp>
 #include <polishing/homopolish.hpp>
@@ -22,58 +25,14 @@
 
 using namespace dbg;
 
-static size_t stage_num = 0;
 std::vector<Contig> ref;
-void PrintPaths(logging::Logger &logger, const std::experimental::filesystem::path &dir, const std::string &stage,
-                SparseDBG &dbg, RecordStorage &readStorage, const io::Library &paths_lib, bool small) {
-    logger.info() << "Entered PrintPaths \n";
-    stage_num += 1;
-    std::string stage_name = itos(stage_num) + "_" + stage;
-    logger.info() << "Dumping current state. Stage id: " << stage_name << std::endl;
-    ensure_dir_existance(dir);
-    ensure_dir_existance(dir / "paths");
-    printDot(dir / (stage_name + ".dot"), Component(dbg), readStorage.labeler());
-    dbg.printFastaOld(dir / (stage_name + ".fasta"));
-    readStorage.printFullAlignments(logger, dir / (stage_name + ".als"));
-    std::vector<Contig> paths;
-    for(StringContig sc : io::SeqReader(paths_lib)) {
-        Contig contig = sc.makeContig();
-        logger.info() << "Config size " << contig.size() << "\n";
-        if(contig.size() > 100000) {
-            paths.emplace_back(contig.seq.Subseq(0, 50000), contig.id + "_start");
-            paths.emplace_back(contig.seq.Subseq(contig.size() - 50000), contig.id + "_end");
-        } else {
-            paths.emplace_back(std::move(contig));
-        }
-    }
-    GraphAlignmentStorage storage(dbg);
-    for(Contig &contig : paths) {
-        storage.fill(contig);
-    }
-    for(Contig &contig : paths) {
-        ensure_dir_existance(dir / "paths" / contig.getId());
-        Component comp = small ? Component::neighbourhood(dbg, contig, dbg.hasher().getK() + 500) :
-                Component::longEdgeNeighbourhood(dbg, contig, 20000);
-        std::function<std::string(Edge &)> labeler = readStorage.labeler() + storage.labeler();
-        logger.info() << "In PrintPaths loop  \n";
-        printDot(dir / "paths" / contig.getId() / (stage_name + ".dot"), comp, labeler);
-    }
-    std::ofstream ref_os;
-    ref_os.open(dir / (stage_name + ".ref"));
-    for(Contig &contig : ref){
-        ref_os << contig.getId() << std::endl;
-        for(const PerfectAlignment<Contig, Edge> &al : GraphAligner(dbg).carefulAlign(contig)) {
-            ref_os << al.seg_from << " " << al.seg_to << std::endl;
-        }
-    }
-    ref_os.close();
-}
 
 std::pair<std::experimental::filesystem::path, std::experimental::filesystem::path>
 AlternativeCorrection(logging::Logger &logger, const std::experimental::filesystem::path &dir,
             const io::Library &reads_lib, const io::Library &pseudo_reads_lib, const io::Library &paths_lib,
         size_t threads, size_t k, size_t w, double threshold, double reliable_coverage,
-bool close_gaps, bool remove_bad, bool skip, bool debug, bool load) {
+bool close_gaps, bool remove_bad, bool skip, bool debug, bool load, const std::string &cache_dir, size_t memory_limit,
+        bool checkpoint, bool resume, diagnostics::DiagnosticsLevel diagnostics_level) {
     logger.info() << "Performing initial correction with k = " << k << std::endl;
     if (k % 2 == 0) {
         logger.info() << "Adjusted k from " << k << " to " << (k + 1) << " to make it odd" << std::endl;
@@ -81,43 +40,69 @@ bool close_gaps, bool remove_bad, bool skip, bool debug, bool load) {
     }
     ensure_dir_existance(dir);
     hashing::RollingHash hasher(k, 239);
-    std::function<void()> ic_task = [&dir, &logger, &hasher, close_gaps, load, remove_bad, k, w, &reads_lib,
-            &pseudo_reads_lib, &paths_lib, threads, threshold, reliable_coverage, debug] {
+    std::function<void()> ic_task = [&dir, &logger, &hasher, close_gaps, load, &cache_dir, memory_limit, remove_bad, k, w, &reads_lib,
+            &pseudo_reads_lib, &paths_lib, threads, threshold, reliable_coverage, debug, checkpoint, resume,
+            diagnostics_level] {
         io::Library construction_lib = reads_lib + pseudo_reads_lib;
-        SparseDBG dbg = load ? DBGPipeline(logger, hasher, w, reads_lib, dir, threads, (dir/"disjointigs.fasta").string(), (dir/"vertices.save").string()) :
-                        DBGPipeline(logger, hasher, w, reads_lib, dir, threads);
+        StageCheckpoints checkpoints(logger, threads, dir / "checkpoints", checkpoint, resume);
+        SparseDBG dbg = checkpoints.resuming() ? checkpoints.loadGraph(hasher) :
+                        load ? DBGPipeline(logger, hasher, w, reads_lib, dir, threads, (dir/"disjointigs.fasta").string(), (dir/"vertices.save").string()) :
+                        CachedDBGPipeline(logger, hasher, w, reads_lib, dir, threads, cache_dir, memory_limit);
         dbg.fillAnchors(w, logger, threads);
+        diagnostics::StateDumper dumper(logger, diagnostics_level, dir / "state_dump", paths_lib, ref);
         size_t extension_size = std::max<size_t>(k * 2, 1000);
         ReadLogger readLogger(threads, dir/"read_log.txt");
         RecordStorage readStorage(dbg, 0, extension_size, threads, readLogger, true, true, false);
         RecordStorage refStorage(dbg, 0, extension_size, threads, readLogger, false, false);
-        io::SeqReader reader(reads_lib);
-        readStorage.fill(reader.begin(), reader.end(), dbg, w + k - 1, logger, threads);
-        coverageStats(logger, dbg);
-        PrintPaths(logger, dir / "state_dump", "initial", dbg, readStorage, paths_lib, true);
-
-        Precorrect(logger, threads, dbg, readStorage, reliable_coverage);
-        RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage}, extension_size);
-        readStorage.trackSuffixes(logger, threads);
-//        CorrectDimers(logger, readStorage, k, threads, reliable_coverage);
-        correctAT(logger, readStorage, k, threads);
-        ManyKCorrect(logger, dbg, readStorage, threshold, reliable_coverage, 800, 4, threads);
-        PrintPaths(logger, dir/ "state_dump", "mk800", dbg, readStorage, paths_lib, true);
-        RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage}, std::max<size_t>(k * 5 / 2, 3000));
-        ManyKCorrect(logger, dbg, readStorage, threshold, reliable_coverage, 2000, 4, threads);
-        PrintPaths(logger, dir/ "state_dump", "mk2000", dbg, readStorage, paths_lib, true);
-        RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage}, std::max<size_t>(k * 7 / 2, 5000));
-//        CorrectDimers(logger, readStorage, k, threads, reliable_coverage);
-        correctAT(logger, readStorage, k, threads);
-        correctLowCoveredRegions(logger, dbg, readStorage, refStorage, "/dev/null", threshold, reliable_coverage, k, threads, false);
-        ManyKCorrect(logger, dbg, readStorage, threshold, reliable_coverage, 3500, 4, threads);
-        RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage});
-        coverageStats(logger, dbg);
-        PrintPaths(logger, dir/ "state_dump", "mk3500", dbg, readStorage, paths_lib, false);
+        checkpoints.track(dbg, {&readStorage, &refStorage});
+        checkpoints.run("fill", [&logger, &dbg, &readStorage, &reads_lib, &dumper, w, k, threads] {
+            io::SeqReader reader(reads_lib);
+            readStorage.fill(reader.begin(), reader.end(), dbg, w + k - 1, logger, threads);
+            coverageStats(logger, dbg);
+            dumper.printPaths("initial", dbg, readStorage, true);
+        });
+        checkpoints.run("precorrect", [&logger, &dbg, &readStorage, threads, reliable_coverage] {
+            Precorrect(logger, threads, dbg, readStorage, reliable_coverage);
+        });
+        checkpoints.run("uncovered1", [&logger, &dbg, &readStorage, &refStorage, threads, extension_size] {
+            RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage}, extension_size);
+        });
+        checkpoints.run("at1", [&logger, &readStorage, k, threads] {
+            readStorage.trackSuffixes(logger, threads);
+//            CorrectDimers(logger, readStorage, k, threads, reliable_coverage);
+            correctAT(logger, readStorage, k, threads);
+        });
+        checkpoints.run("mk800", [&logger, &dbg, &readStorage, &dumper, threshold, reliable_coverage, threads] {
+            ManyKCorrect(logger, dbg, readStorage, threshold, reliable_coverage, 800, 4, threads);
+            dumper.printPaths("mk800", dbg, readStorage, true);
+        });
+        checkpoints.run("uncovered2", [&logger, &dbg, &readStorage, &refStorage, k, threads] {
+            RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage}, std::max<size_t>(k * 5 / 2, 3000));
+        });
+        checkpoints.run("mk2000", [&logger, &dbg, &readStorage, &dumper, threshold, reliable_coverage, threads] {
+            ManyKCorrect(logger, dbg, readStorage, threshold, reliable_coverage, 2000, 4, threads);
+            dumper.printPaths("mk2000", dbg, readStorage, true);
+        });
+        checkpoints.run("uncovered3", [&logger, &dbg, &readStorage, &refStorage, k, threads] {
+            RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage}, std::max<size_t>(k * 7 / 2, 5000));
+        });
+        checkpoints.run("low", [&logger, &dbg, &readStorage, &refStorage, threshold, reliable_coverage, k, threads] {
+//            CorrectDimers(logger, readStorage, k, threads, reliable_coverage);
+            correctAT(logger, readStorage, k, threads);
+            correctLowCoveredRegions(logger, dbg, readStorage, refStorage, "/dev/null", threshold, reliable_coverage, k, threads, false);
+        });
+        checkpoints.run("mk3500", [&logger, &dbg, &readStorage, threshold, reliable_coverage, threads] {
+            ManyKCorrect(logger, dbg, readStorage, threshold, reliable_coverage, 3500, 4, threads);
+        });
+        checkpoints.run("uncovered4", [&logger, &dbg, &readStorage, &refStorage, &dumper, threads] {
+            RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage});
+            coverageStats(logger, dbg);
+            dumper.printPaths("mk3500", dbg, readStorage, false);
+        });
         readStorage.printReadFasta(logger, dir / "corrected.fasta");
 
-        DrawSplit(Component(dbg), dir / "split");
-        dbg.printFastaOld(dir / "graph.fasta");
+        dumper.drawSplit(dbg, dir / "split");
+        dbg.printFastaOld(dir / "graph.fasta", threads);
     };
     if(!skip)
         runInFork(ic_task);
@@ -129,7 +114,8 @@ bool close_gaps, bool remove_bad, bool skip, bool debug, bool load) {
 
 std::vector<std::experimental::filesystem::path> NoCorrection(logging::Logger &logger, const std::experimental::filesystem::path &dir,
                 const io::Library &reads_lib, const io::Library &pseudo_reads_lib, const io::Library &paths_lib,
-                size_t threads, size_t k, size_t w, bool skip, bool debug, bool load) {
+                size_t threads, size_t k, size_t w, bool skip, bool debug, bool load, const std::string &cache_dir,
+                size_t memory_limit, diagnostics::DiagnosticsLevel diagnostics_level) {
     logger.info() << "Performing initial correction with k = " << k << std::endl;
     if (k % 2 == 0) {
         logger.info() << "Adjusted k from " << k << " to " << (k + 1) << " to make it odd" << std::endl;
@@ -137,12 +123,13 @@ std::vector<std::experimental::filesystem::path> NoCorrection(logging::Logger &l
     }
     ensure_dir_existance(dir);
     hashing::RollingHash hasher(k, 239);
-    std::function<void()> ic_task = [&dir, &logger, &hasher, load, k, w, &reads_lib,
-            &pseudo_reads_lib, &paths_lib, threads, debug] {
+    std::function<void()> ic_task = [&dir, &logger, &hasher, load, &cache_dir, memory_limit, k, w, &reads_lib,
+            &pseudo_reads_lib, &paths_lib, threads, debug, diagnostics_level] {
         io::Library construction_lib = reads_lib + pseudo_reads_lib;
         SparseDBG dbg = load ? DBGPipeline(logger, hasher, w, reads_lib, dir, threads, (dir/"disjointigs.fasta").string(), (dir/"vertices.save").string()) :
-                        DBGPipeline(logger, hasher, w, reads_lib, dir, threads);
+                        CachedDBGPipeline(logger, hasher, w, reads_lib, dir, threads, cache_dir, memory_limit);
         dbg.fillAnchors(w, logger, threads);
+        diagnostics::StateDumper dumper(logger, diagnostics_level, dir / "state_dump", paths_lib, ref);
         size_t extension_size = std::max<size_t>(k * 2, 1000);
         ReadLogger readLogger(threads, dir/"read_log.txt");
         RecordStorage readStorage(dbg, 0, extension_size, threads, readLogger, true, true, false);
@@ -151,13 +138,13 @@ std::vector<std::experimental::filesystem::path> NoCorrection(logging::Logger &l
         readStorage.fill(reader.begin(), reader.end(), dbg, w + k - 1, logger, threads);
         coverageStats(logger, dbg);
 
-        PrintPaths(logger, dir / "state_dump", "initial", dbg, readStorage, paths_lib, true);
+        dumper.printPaths("initial", dbg, readStorage, true);
 
         logger.info() << "Print before final_dbg" << std::endl;
 
-        dbg.printFastaOld(dir / "final_dbg.fasta");
-        printDot(dir / "final_dbg.dot", Component(dbg), readStorage.labeler());
-        printGFA(dir / "final_dbg.gfa", Component(dbg), true);
+        dbg.printFastaOld(dir / "final_dbg.fasta", threads);
+        printDot(dir / "final_dbg.dot", Component(dbg), readStorage.labeler(), threads);
+        printGFA(dir / "final_dbg.gfa", Component(dbg), true, threads);
         SaveAllReads(dir/"final_dbg.aln", {&readStorage, &extra_reads});
         readStorage.printReadFasta(logger, dir / "corrected_reads.fasta");
     };
@@ -167,11 +154,93 @@ std::vector<std::experimental::filesystem::path> NoCorrection(logging::Logger &l
     return {dir/"corrected_reads.fasta", dir / "final_dbg.fasta", dir / "final_dbg.aln"};
 }
 
+//Receives the graph and read alignments at the end of a stage when the next stage is run in the same process
+typedef std::function<void(SparseDBG &, RecordStorage &, RecordStorage &)> GraphHandover;
+
+//Second phase of error correction. The corrected graph, read alignments and corrected reads are saved only if
+//save_results is set and are passed to next before they are destroyed.
+void SecondPhaseCorrection(
+        logging::Logger &logger, const std::experimental::filesystem::path &dir,
+        const io::Library &reads_lib, const io::Library &pseudo_reads_lib,
+        const io::Library &paths_lib, size_t threads, size_t k, size_t w, double threshold, double reliable_coverage,
+        size_t unique_threshold, bool diploid, bool debug, bool load, const std::string &cache_dir, size_t memory_limit,
+        bool checkpoint, bool resume, diagnostics::DiagnosticsLevel diagnostics_level, bool save_results, const GraphHandover &next) {
+    hashing::RollingHash hasher(k, 239);
+    io::Library construction_lib = reads_lib + pseudo_reads_lib;
+    StageCheckpoints checkpoints(logger, threads, dir / "checkpoints", checkpoint, resume);
+    SparseDBG dbg =
+        checkpoints.resuming() ? checkpoints.loadGraph(hasher) :
+        load ? DBGPipeline(logger, hasher, w, reads_lib, dir, threads,
+                           (dir/"disjointigs.fasta").string(),
+                           (dir/"vertices.save").string())
+             : CachedDBGPipeline(logger, hasher, w, reads_lib, dir, threads, cache_dir, memory_limit);
+    dbg.fillAnchors(w, logger, threads);
+    diagnostics::StateDumper dumper(logger, diagnostics_level, dir / "state_dump", paths_lib, ref);
+    size_t extension_size = 10000000;
+    ReadLogger readLogger(threads, dir/"read_log.txt");
+    RecordStorage readStorage(dbg, 0, extension_size, threads, readLogger, true, debug);
+    RecordStorage refStorage(dbg, 0, extension_size, threads, readLogger, false, false);
+    RecordStorage extra_reads(dbg, 0, 10000000000ull, threads, readLogger, false, debug);
+    checkpoints.track(dbg, {&readStorage, &refStorage, &extra_reads});
+    checkpoints.run("fill", [&logger, &dbg, &readStorage, &reads_lib, &dumper, &dir, w, k, threads] {
+        io::SeqReader reader(reads_lib);
+        readStorage.fill(reader.begin(), reader.end(), dbg, w + k - 1, logger, threads);
+        dumper.drawSplit(dbg, dir / "before_figs", readStorage.labeler(), 25000);
+        dumper.printPaths("initial", dbg, readStorage, false);
+    });
+    checkpoints.run("low", [&logger, &dbg, &readStorage, &refStorage, &dumper, &dir, threshold, reliable_coverage, threads] {
+        initialCorrect(dbg, logger, dir / "correction.txt", readStorage, refStorage,
+                       threshold, 2 * threshold, reliable_coverage, threads, false);
+        dumper.printPaths("low", dbg, readStorage, false);
+    });
+    checkpoints.run("gap1", [&logger, &dbg, &readStorage, &refStorage, &dumper, threads] {
+        GapColserPipeline(logger, threads, dbg, {&readStorage, &refStorage});
+        dumper.printPaths("gap1", dbg, readStorage, false);
+    });
+    checkpoints.run("bad", [&logger, &dbg, &readStorage, &dumper, threshold, threads] {
+        readStorage.invalidateBad(logger, threads, threshold, "after_gap1");
+        dumper.printPaths("bad", dbg, readStorage, false);
+    });
+    checkpoints.run("uncovered1", [&logger, &dbg, &readStorage, &refStorage, &dumper, threads] {
+        RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage});
+        dumper.printPaths("uncovered1", dbg, readStorage, false);
+    });
+    checkpoints.run("mult", [&logger, &dbg, &readStorage, &extra_reads, &dumper, &dir, unique_threshold, diploid,
+                             debug, threads] {
+        extra_reads = MultCorrect(dbg, logger, dir, readStorage, unique_threshold, threads, diploid, debug);
+        MRescue(logger, threads, dbg, readStorage, unique_threshold, 0.05);
+        dumper.printPaths("mult", dbg, readStorage, false);
+    });
+    checkpoints.run("uncovered2", [&logger, &dbg, &readStorage, &refStorage, &extra_reads, &dumper, threads] {
+        RemoveUncovered(logger, threads, dbg, {&readStorage, &extra_reads, &refStorage});
+        dumper.printPaths("uncovered2", dbg, readStorage, false);
+    });
+    checkpoints.run("gap2", [&logger, &dbg, &readStorage, &refStorage, &extra_reads, &dumper, &dir, threads] {
+        GapColserPipeline(logger, threads, dbg, {&readStorage, &extra_reads, &refStorage});
+        dumper.printPaths("gap2", dbg, readStorage, false);
+        dumper.drawSplit(dbg, dir / "split_figs", readStorage.labeler());
+    });
+
+    if(save_results) {
+        dbg.printFastaOld(dir / "final_dbg.fasta", threads);
+        printDot(dir / "final_dbg.dot", Component(dbg), readStorage.labeler(), threads);
+        printGFA(dir / "final_dbg.gfa", Component(dbg), true, threads);
+    }
+    dumper.printPaths("nname", dbg, readStorage, false);
+    if(save_results) {
+        SaveAllReads(dir/"final_dbg.aln", {&readStorage, &extra_reads});
+        readStorage.printReadFasta(logger, dir / "corrected_reads.fasta");
+    }
+    if(next)
+        next(dbg, readStorage, extra_reads);
+}
+
 std::vector<std::experimental::filesystem::path> SecondPhase(
     logging::Logger &logger, const std::experimental::filesystem::path &dir,
     const io::Library &reads_lib, const io::Library &pseudo_reads_lib,
     const io::Library &paths_lib, size_t threads, size_t k, size_t w, double threshold, double reliable_coverage,
-    size_t unique_threshold, bool diploid, bool skip, bool debug, bool load) {
+    size_t unique_threshold, bool diploid, bool skip, bool debug, bool load, const std::string &cache_dir,
+    size_t memory_limit, bool checkpoint, bool resume, diagnostics::DiagnosticsLevel diagnostics_level) {
     logger.info() << "Performing second phase of error correction using k = " << k << std::endl;
     if (k%2==0) {
         logger.info() << "Adjusted k from " << k << " to " << (k + 1)
@@ -179,56 +248,14 @@ std::vector<std::experimental::filesystem::path> SecondPhase(
         k += 1;
     }
     ensure_dir_existance(dir);
-    hashing::RollingHash hasher(k, 239);
-    std::function<void()> ic_task = [&dir, &logger, &hasher, load, k, w,
+    std::function<void()> ic_task = [&dir, &logger, load, &cache_dir, memory_limit, k, w,
                                      &reads_lib, &pseudo_reads_lib, &paths_lib,
                                      threads, threshold, reliable_coverage,
-                                     debug, unique_threshold, diploid]
+                                     debug, unique_threshold, diploid, checkpoint, resume, diagnostics_level]
                                      {
-        io::Library construction_lib = reads_lib + pseudo_reads_lib;
-        SparseDBG dbg =
-            load ? DBGPipeline(logger, hasher, w, reads_lib, dir, threads,
-                               (dir/"disjointigs.fasta").string(),
-                               (dir/"vertices.save").string())
-                 : DBGPipeline(logger, hasher, w, reads_lib, dir, threads);
-        dbg.fillAnchors(w, logger, threads);
-        size_t extension_size = 10000000;
-        ReadLogger readLogger(threads, dir/"read_log.txt");
-        RecordStorage readStorage(dbg, 0, extension_size, threads, readLogger, true, debug);
-        RecordStorage refStorage(dbg, 0, extension_size, threads, readLogger, false, false);
-        io::SeqReader reader(reads_lib);
-        readStorage.fill(reader.begin(), reader.end(), dbg, w + k - 1, logger, threads);
-
-        DrawSplit(Component(dbg), dir / "before_figs", readStorage.labeler(), 25000);
-        PrintPaths(logger, dir / "state_dump", "initial", dbg, readStorage, paths_lib, false);
-
-        initialCorrect(dbg, logger, dir / "correction.txt", readStorage, refStorage,
-                       threshold, 2 * threshold, reliable_coverage, threads, false);
-
-        PrintPaths(logger, dir/ "state_dump", "low", dbg, readStorage, paths_lib, false);
-        GapColserPipeline(logger, threads, dbg, {&readStorage, &refStorage});
-
-        PrintPaths(logger, dir/ "state_dump", "gap1", dbg, readStorage, paths_lib, false);
-        readStorage.invalidateBad(logger, threads, threshold, "after_gap1");
-        PrintPaths(logger, dir/ "state_dump", "bad", dbg, readStorage, paths_lib, false);
-        RemoveUncovered(logger, threads, dbg, {&readStorage, &refStorage});
-        PrintPaths(logger, dir/ "state_dump", "uncovered1", dbg, readStorage, paths_lib, false);
-        RecordStorage extra_reads = MultCorrect(dbg, logger, dir, readStorage, unique_threshold, threads, diploid, debug);
-        MRescue(logger, threads, dbg, readStorage, unique_threshold, 0.05);
-        PrintPaths(logger, dir/ "state_dump", "mult", dbg, readStorage, paths_lib, false);
-        RemoveUncovered(logger, threads, dbg, {&readStorage, &extra_reads, &refStorage});
-        PrintPaths(logger, dir/ "state_dump", "uncovered2", dbg, readStorage, paths_lib, false);
-        GapColserPipeline(logger, threads, dbg, {&readStorage, &extra_reads, &refStorage});
-
-        PrintPaths(logger, dir / "state_dump", "gap2", dbg, readStorage, paths_lib, false);
-        DrawSplit(Component(dbg), dir / "split_figs", readStorage.labeler());
-
-        dbg.printFastaOld(dir / "final_dbg.fasta");
-        printDot(dir / "final_dbg.dot", Component(dbg), readStorage.labeler());
-        printGFA(dir / "final_dbg.gfa", Component(dbg), true);
-        PrintPaths(logger, dir/ "state_dump", "nname", dbg, readStorage, paths_lib, false);
-        SaveAllReads(dir/"final_dbg.aln", {&readStorage, &extra_reads});
-        readStorage.printReadFasta(logger, dir / "corrected_reads.fasta");
+        SecondPhaseCorrection(logger, dir, reads_lib, pseudo_reads_lib, paths_lib, threads, k, w, threshold,
+                              reliable_coverage, unique_threshold, diploid, debug, load, cache_dir, memory_limit, checkpoint,
+                              resume, diagnostics_level, true, nullptr);
     };
     if(!skip)
         runInFork(ic_task);
@@ -243,7 +270,7 @@ void GetFinalPrint(
         logging::Logger &logger, const std::experimental::filesystem::path &dir,
         const io::Library &reads_lib, const io::Library &pseudo_reads_lib,
         const io::Library &paths_lib, size_t threads, size_t k, size_t w, double threshold, double reliable_coverage,
-        size_t unique_threshold, bool diploid, bool skip, bool debug, bool load) {
+        size_t unique_threshold, bool diploid, bool skip, bool debug, bool load, diagnostics::DiagnosticsLevel diagnostics_level) {
     logger.info() << "GetFinalPrint;   k = " << k << std::endl;
 
 
@@ -252,7 +279,7 @@ void GetFinalPrint(
     std::function<void()> ic_task = [&dir, &logger, &hasher, load, k, w,
             &reads_lib, &pseudo_reads_lib, &paths_lib,
             threads, threshold, reliable_coverage,
-            debug, unique_threshold, diploid]
+            debug, unique_threshold, diploid, diagnostics_level]
             {
         io::Library construction_lib = reads_lib + pseudo_reads_lib;
         SparseDBG dbg =
@@ -261,6 +288,7 @@ void GetFinalPrint(
                                    (dir/"vertices.save").string())
                      : DBGPipeline(logger, hasher, w, reads_lib, dir, threads);
         dbg.fillAnchors(w, logger, threads);
+        diagnostics::StateDumper dumper(logger, diagnostics_level, dir / "state_dump", paths_lib, ref);
         size_t extension_size = 10000000;
         ReadLogger readLogger(threads, dir/"read_log.txt");
         RecordStorage readStorage(dbg, 0, extension_size, threads, readLogger, true, debug);
@@ -268,12 +296,44 @@ void GetFinalPrint(
         io::SeqReader reader(reads_lib);
         readStorage.fill(reader.begin(), reader.end(), dbg, w + k - 1, logger, threads);
 
-        DrawSplit(Component(dbg), dir / "before_figs", readStorage.labeler(), 25000);
-        PrintPaths(logger, dir / "state_dump", "initial", dbg, readStorage, paths_lib, false);
+        dumper.drawSplit(dbg, dir / "before_figs", readStorage.labeler(), 25000);
+        dumper.printPaths("initial", dbg, readStorage, false);
     };
     runInFork(ic_task);
 }
 
+//Resolves repeats and returns the resolved graph. Its GFA file is written only with save_gfa.
+repeat_resolution::GFAGraph RunRepeatResolution(logging::Logger &logger, size_t threads, size_t k, size_t kmdbg,
+                                                size_t unique_threshold, bool diploid,
+                                                const std::experimental::filesystem::path &dir, SparseDBG &dbg,
+                                                RecordStorage &readStorage, RecordStorage &extra_reads, bool debug,
+                                                bool save_gfa = true) {
+    repeat_resolution::RepeatResolver rr(dbg, &readStorage, {&extra_reads},
+                                         k, kmdbg, dir, unique_threshold,
+                                         diploid, debug, threads, logger);
+    return rr.ResolveRepeats(logger, threads, save_gfa);
+}
+
+//Builds the same graph that LoadGFA reads from the GFA file of the resolved graph
+multigraph::MultiGraph ResolvedGraph(const repeat_resolution::GFAGraph &gfa) {
+    multigraph::MultiGraph vertex_graph;
+    std::unordered_map<repeat_resolution::RREdgeIndexType, multigraph::Vertex *> vmap;
+    for(const std::pair<repeat_resolution::RREdgeIndexType, Sequence> &segment : gfa.segments) {
+        VERIFY(vmap.find(segment.first) == vmap.end());
+        vmap[segment.first] = &vertex_graph.addVertex(segment.second, int(segment.first));
+    }
+    for(const repeat_resolution::GFAGraph::Link &link : gfa.links) {
+        multigraph::Vertex *v1 = vmap[link.from];
+        multigraph::Vertex *v2 = vmap[link.to];
+        if(!link.from_forward)
+            v1 = v1->rc;
+        if(!link.to_forward)
+            v2 = v2->rc;
+        vertex_graph.addLink(*v1, *v2, link.overlap);
+    }
+    return std::move(vertex_graph);
+}
+
 std::vector<std::experimental::filesystem::path> MDBGPhase(
         logging::Logger &logger, size_t threads, size_t k, size_t kmdbg, size_t w, size_t unique_threshold, bool diploid,
         const std::experimental::filesystem::path &dir,
@@ -288,46 +348,122 @@ std::vector<std::experimental::filesystem::path> MDBGPhase(
         RecordStorage readStorage(dbg, 0, extension_size, threads, readLogger, true, debug);
         RecordStorage extra_reads(dbg, 0, extension_size, threads, readLogger, false, debug);
         LoadAllReads(read_paths, {&readStorage, &extra_reads}, dbg);
-        repeat_resolution::RepeatResolver rr(dbg, &readStorage, {&extra_reads},
-                                             k, kmdbg, dir, unique_threshold,
-                                             diploid, debug, logger);
-        rr.ResolveRepeats(logger, threads);
+        RunRepeatResolution(logger, threads, k, kmdbg, unique_threshold, diploid, dir, dbg, readStorage, extra_reads, debug);
     };
     if(!skip)
         runInFork(ic_task);
     return {dir / "assembly.hpc.fasta", dir / "mdbg.hpc.gfa"};
 }
 
+//Polishes edges of the resolved graph and prints the final assembly. Corrected reads are taken from the iterator,
+//which reads them either from a file or from a RecordStorage in memory. Read alignments are passed to polishing
+//in memory and are saved to disk only when a checkpoint is requested.
+template<class I>
+void PolishGraph(logging::Logger &logger, size_t threads, const std::experimental::filesystem::path &dir,
+                 const std::experimental::filesystem::path &output_dir, multigraph::MultiGraph &edge_graph,
+                 I corrected_begin, I corrected_end, const io::Library &reads, size_t dicompress, size_t min_alignment,
+                 size_t window_length, bool checkpoint, bool debug) {
+    std::vector<Contig> contigs = edge_graph.getEdges(false);
+    binary_alignments::AlignmentStorage alignments =
+            CollectAlignments(logger, threads, contigs, corrected_begin, corrected_end, min_alignment);
+    if(checkpoint) {
+        ensure_dir_existance(dir);
+        logger.info() << "Saving read alignments to " << (dir / "alignments.bin") << std::endl;
+        alignments.Write(dir / "alignments.bin");
+    }
+    std::vector<Contig> uncompressed = Polish(logger, threads, contigs, alignments.view(), reads, dicompress,
+                                                window_length);
+    std::vector<Contig> assembly = printUncompressedResults(logger, threads, edge_graph, uncompressed, output_dir, debug);
+    logger.info() << "Printing final assembly to " << (output_dir / "assembly.fasta") << std::endl;
+    std::ofstream os_cut;
+    os_cut.open(output_dir / "assembly.fasta");
+    for(Contig &contig : assembly) {
+        if(contig.size() > 1500)
+            os_cut << ">" << contig.id << "\n" << contig.seq << "\n";
+    }
+    os_cut.close();
+}
+
+//Reloads the resolved graph and corrected reads from files. Used when polishing is run as a separate stage.
+void PolishResolvedGraph(logging::Logger &logger, size_t threads, const std::experimental::filesystem::path &dir,
+                         const std::experimental::filesystem::path &output_dir,
+                         const std::experimental::filesystem::path &gfa_file,
+                         const std::experimental::filesystem::path &corrected_reads,
+                         const io::Library &reads, size_t dicompress, size_t min_alignment, size_t window_length,
+                         bool checkpoint, bool debug) {
+    io::SeqReader reader(corrected_reads);
+    multigraph::MultiGraph vertex_graph;
+    vertex_graph.LoadGFA(gfa_file, true);
+    multigraph::MultiGraph edge_graph = vertex_graph.DBG();
+    PolishGraph(logger, threads, dir, output_dir, edge_graph, reader.begin(), reader.end(), reads, dicompress,
+                min_alignment, window_length, checkpoint, debug);
+}
+
 std::vector<std::experimental::filesystem::path> PolishingPhase(
         logging::Logger &logger, size_t threads, const std::experimental::filesystem::path &dir,
         const std::experimental::filesystem::path &output_dir,
         const std::experimental::filesystem::path &gfa_file,
         const std::experimental::filesystem::path &corrected_reads,
-        const io::Library &reads, size_t dicompress, size_t min_alignment, bool skip, bool debug) {
+        const io::Library &reads, size_t dicompress, size_t min_alignment, size_t window_length, bool skip,
+        bool checkpoint, bool debug) {
     logger.info() << "Performing polishing and homopolymer uncompression" << std::endl;
-    std::function<void()> ic_task = [&logger, threads, &output_dir, debug, &gfa_file, &corrected_reads, &reads, dicompress, min_alignment, &dir] {
-        io::SeqReader reader(corrected_reads);
-        multigraph::MultiGraph vertex_graph;
-        vertex_graph.LoadGFA(gfa_file, true);
-        multigraph::MultiGraph edge_graph = vertex_graph.DBG();
-        std::vector<Contig> contigs = edge_graph.getEdges(false);
-        auto res = PrintAlignments(logger, threads, contigs, reader.begin(), reader.end(), min_alignment, dir);
-        std::vector<Contig> uncompressed = Polish(logger, threads, contigs, res.first, reads, dicompress);
-        std::vector<Contig> assembly = printUncompressedResults(logger, threads, edge_graph, uncompressed, output_dir, debug);
-        logger.info() << "Printing final assembly to " << (output_dir / "assembly.fasta") << std::endl;
-        std::ofstream os_cut;
-        os_cut.open(output_dir / "assembly.fasta");
-        for(Contig &contig : assembly) {
-            if(contig.size() > 1500)
-                os_cut << ">" << contig.id << "\n" << contig.seq << "\n";
-        }
-        os_cut.close();
+    std::function<void()> ic_task = [&logger, threads, &output_dir, debug, &gfa_file, &corrected_reads, &reads,
+                                     dicompress, min_alignment, window_length, checkpoint, &dir] {
+        PolishResolvedGraph(logger, threads, dir, output_dir, gfa_file, corrected_reads, reads, dicompress,
+                            min_alignment, window_length, checkpoint, debug);
     };
     if(!skip)
         runInFork(ic_task);
     return {output_dir / "assembly.fasta", output_dir / "mdbg.gfa"};
 }
 
+//Runs second phase of error correction, repeat resolution and polishing in a single process. De Bruijn graph and
+//read alignments are passed to repeat resolution in memory instead of being saved and realigned. Resolved graph and
+//corrected reads are passed to polishing in memory, so reads are only realigned to the new contigs.
+//Intermediate files that are only needed to restart from a later stage are written only with checkpoint.
+void InMemoryPhases(logging::Logger &logger, size_t threads, const std::experimental::filesystem::path &dir,
+                    const std::pair<std::experimental::filesystem::path, std::experimental::filesystem::path> &corrected1,
+                    const io::Library &paths_lib, const io::Library &reads, size_t k, size_t w, size_t kmdbg,
+                    double threshold, double reliable_coverage, size_t unique_threshold, bool diploid, size_t dicompress,
+                    bool checkpoint, bool resume, bool debug, bool load, const std::string &cache_dir,
+                    size_t memory_limit, diagnostics::DiagnosticsLevel diagnostics_level) {
+    logger.info() << "Performing second phase of error correction, repeat resolution and polishing in memory" << std::endl;
+    size_t min_alignment = k;
+    std::experimental::filesystem::path k_dir = dir / ("k" + itos(k));
+    if (k % 2 == 0) {
+        logger.info() << "Adjusted k from " << k << " to " << (k + 1) << " to make it odd" << std::endl;
+        k += 1;
+    }
+    ensure_dir_existance(k_dir);
+    std::function<void()> ic_task = [&logger, threads, &dir, &k_dir, &corrected1, &paths_lib, &reads, k, w, kmdbg,
+                                     threshold, reliable_coverage, unique_threshold, diploid, dicompress, min_alignment,
+                                     checkpoint, resume, debug, load, &cache_dir, memory_limit, diagnostics_level] {
+        GraphHandover resolve = [&logger, threads, &dir, &reads, k, kmdbg, unique_threshold, diploid, dicompress,
+                                 min_alignment, memory_limit, checkpoint, debug]
+                (SparseDBG &dbg, RecordStorage &readStorage, RecordStorage &extra_reads) {
+            logger.info() << "Performing repeat resolution by transforming de Bruijn graph into Multiplex de Bruijn graph" << std::endl;
+            multigraph::MultiGraph vertex_graph = ResolvedGraph(
+                    RunRepeatResolution(logger, threads, k, kmdbg, unique_threshold, diploid, dir / "mdbg", dbg,
+                                        readStorage, extra_reads, debug, checkpoint));
+            multigraph::MultiGraph edge_graph = vertex_graph.DBG();
+            logger.info() << "Performing polishing and homopolymer uncompression" << std::endl;
+            PolishGraph(logger, threads, dir / "uncompressing", dir, edge_graph, readStorage.correctedBegin(),
+                        readStorage.correctedEnd(), reads, dicompress, min_alignment, PolishingWindow(memory_limit),
+                        checkpoint, debug);
+        };
+        SecondPhaseCorrection(logger, k_dir, {corrected1.first}, {corrected1.second}, paths_lib, threads, k, w,
+                              threshold, reliable_coverage, unique_threshold, diploid, debug, load, cache_dir, memory_limit,
+                              checkpoint, resume, diagnostics_level, checkpoint, resolve);
+//        Disjointigs and junctions are handed over from the construction subprocess through files in k_dir.
+//        They are only needed to restart with --load, so they are kept only with checkpoint.
+        if(!checkpoint) {
+            std::experimental::filesystem::remove(k_dir / "disjointigs.fasta");
+            std::experimental::filesystem::remove(k_dir / "vertices.save");
+        }
+    };
+    runInFork(ic_task);
+}
+
 std::string constructMessage() {
     std::stringstream ss;
     ss << "LJA: genome assembler for PacBio HiFi reads based on de Bruijn graph.\n";
@@ -341,6 +477,12 @@ std::string constructMessage() {
     ss << "  -k <int>                                      Value of k used for initial error correction.\n";
     ss << "  -K <int>                                      Value of k used for final error correction and initialization of multiDBG.\n";
     ss << "  --diploid                                     Use this option for diploid genomes. By default LJA assumes that the genome is haploid or inbred.\n";
+    ss << "  --checkpoint                                  Save intermediate data that is otherwise passed between stages in memory and the state of error correction after each of its substeps.\n";
+    ss << "  --in-memory                                   Pass graph, read alignments and corrected reads from error correction to repeat resolution and polishing in memory. Intermediate files needed to restart from later stages, including corrected reads and the homopolymer compressed graph, are saved only with --checkpoint.\n";
+    ss << "  --resume                                      Continue the first stage that is run from the last substep saved with --checkpoint.\n";
+    ss << "  --diagnostics <off|summary|full>              Dump intermediate graphs after every stage for debugging. Dumps are rendered on the pipeline thread and only written to disk in the background. The default value is off.\n";
+    ss << "  --cache-dir <dir_name>                        Reuse disjointigs and junctions saved in this directory by previous runs on the same reads with the same k and w. New ones are saved there too. By default no cache is used.\n";
+    ss << "  --memory-limit <int>                          Memory ceiling in Gb. When set, minimizer and junction selection during de Bruijn graph construction process disk buckets in the output directory one at a time, read buffers are sized to the ceiling and polishing processes contigs in windows whose votes fit into a quarter of the ceiling. By default everything is kept in memory.\n";
     return ss.str();
 }
 
@@ -364,7 +506,13 @@ int main(int argc, char **argv) {
                      "noec",
                      "alternative",
                      "diploid",
+                     "checkpoint",
+                     "in-memory",
+                     "resume",
                      "debug",
+                     "diagnostics=off",
+                     "cache-dir=none",
+                     "memory-limit=0",
                      "help"},
                     {"reads", "paths", "ref"},
                     {"o=output-dir", "t=threads", "k=k-mer-size","w=window", "K=K-mer-size","W=Window", "h=help"},
@@ -388,6 +536,8 @@ int main(int argc, char **argv) {
     }
 
     bool debug = parser.getCheck("debug");
+    bool checkpoint = parser.getCheck("checkpoint");
+    diagnostics::DiagnosticsLevel diagnostics_level = diagnostics::ParseLevel(parser.getValue("diagnostics"));
     StringContig::homopolymer_compressing = true;
     StringContig::SetDimerParameters(parser.getValue("dimer-compress"));
     const std::experimental::filesystem::path dir(parser.getValue("output-dir"));
@@ -406,6 +556,11 @@ int main(int argc, char **argv) {
     bool skip = first_stage != "none";
     bool load = parser.getCheck("load");
     bool noec = parser.getCheck("noec");
+    bool in_memory = parser.getCheck("in-memory");
+    bool resume = parser.getCheck("resume");
+    std::string cache_dir = parser.getValue("cache-dir");
+    size_t memory_limit = std::stoull(parser.getValue("memory-limit")) << 30u;
+    memory_budget::Set(memory_limit);
     logger.info() << "LJA pipeline started" << std::endl;
 
     size_t threads = std::stoi(parser.getValue("threads"));
@@ -425,9 +580,10 @@ int main(int argc, char **argv) {
     size_t unique_threshold = std::stoi(parser.getValue("unique-threshold"));
 
     std::vector<std::experimental::filesystem::path> corrected_final;
+    bool ran_in_memory = false;
     if(noec) {
         corrected_final = NoCorrection(logger, dir / ("k" + itos(K)), lib, {}, paths, threads, K, W,
-                                       skip, debug, load);
+                                       skip, debug, load, cache_dir, memory_limit, diagnostics_level);
     } else {
         double threshold = std::stod(parser.getValue("cov-threshold"));
         double reliable_coverage = std::stod(parser.getValue("rel-threshold"));
@@ -435,19 +591,32 @@ int main(int argc, char **argv) {
         if (first_stage == "alternative")
             skip = false;
         corrected1 = AlternativeCorrection(logger, dir / ("k" + itos(k)), lib, {}, paths, threads, k, w,
-                                           threshold, reliable_coverage, false, false, skip, debug, load);
-        if (first_stage == "alternative" || first_stage == "none")
+                                           threshold, reliable_coverage, false, false, skip, debug, load, cache_dir,
+                                           memory_limit, checkpoint, resume, diagnostics_level);
+        if (first_stage == "alternative" || first_stage == "none") {
             load = false;
+            resume = false;
+        }
 
         double Threshold = std::stod(parser.getValue("Cov-threshold"));
         double Reliable_coverage = std::stod(parser.getValue("Rel-threshold"));
 
         if (first_stage == "phase2")
             skip = false;
+        if (in_memory && !skip) {
+            InMemoryPhases(logger, threads, dir, corrected1, paths, lib, K, W, KmDBG, Threshold, Reliable_coverage,
+                           unique_threshold, diploid, StringContig::max_dimer_size / 2, checkpoint, resume, debug,
+                           load, cache_dir, memory_limit, diagnostics_level);
+            ran_in_memory = true;
+            skip = true;
+        }
         corrected_final = SecondPhase(logger, dir / ("k" + itos(K)), {corrected1.first}, {corrected1.second}, paths,
-                                      threads, K, W, Threshold, Reliable_coverage, unique_threshold, diploid, skip, debug, load);
-        if (first_stage == "phase2")
+                                      threads, K, W, Threshold, Reliable_coverage, unique_threshold, diploid, skip, debug, load,
+                                      cache_dir, memory_limit, checkpoint, resume, diagnostics_level);
+        if (first_stage == "phase2") {
             load = false;
+            resume = false;
+        }
     }
     if(first_stage == "rr")
         skip = false;
@@ -462,14 +631,16 @@ int main(int argc, char **argv) {
     std::vector<std::experimental::filesystem::path> uncompressed_results =
             PolishingPhase(logger, threads, dir/ "uncompressing", dir, resolved[1],
                            corrected_final[0],
-                           lib, StringContig::max_dimer_size / 2, K, skip, debug);
+                           lib, StringContig::max_dimer_size / 2, K, PolishingWindow(memory_limit), skip, checkpoint, debug);
     if(first_stage == "polishing")
         load = false;
 //    GetFinalPrint(logger, dir / ("k" + itos(K)), {corrected1.first}, {corrected1.second}, paths,
 //                  threads, K, W, Threshold, Reliable_coverage, unique_threshold, diploid, skip, debug, load);
 
-    logger.info() << "Final homopolymer compressed and corrected reads can be found here: " << corrected_final[0] << std::endl;
-    logger.info() << "Final graph with homopolymer compressed edges can be found here: " << resolved[1] << std::endl;
+    if(!ran_in_memory || checkpoint) {
+        logger.info() << "Final homopolymer compressed and corrected reads can be found here: " << corrected_final[0] << std::endl;
+        logger.info() << "Final graph with homopolymer compressed edges can be found here: " << resolved[1] << std::endl;
+    }
     logger.info() << "Final graph can be found here: " << uncompressed_results[1] << std::endl;
     logger.info() << "Final assembly can be found here: " << uncompressed_results[0] << std::endl;
     logger.info() << "LJA pipeline finished" << std::endl;
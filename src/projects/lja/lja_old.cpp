@@ -258,7 +258,7 @@ std::vector<std::experimental::filesystem::path> MDBGPhase(
         LoadAllReads(read_paths, {&readStorage, &extra_reads}, dbg);
         repeat_resolution::RepeatResolver rr(dbg, &readStorage, {&extra_reads},
                                              k, kmdbg, dir, unique_threshold,
-                                             diploid, debug, logger);
+                                             diploid, debug, threads, logger);
         rr.ResolveRepeats(logger, threads);
     };
     if(!skip)
@@ -279,8 +279,8 @@ std::vector<std::experimental::filesystem::path> PolishingPhase(
         vertex_graph.LoadGFA(gfa_file, true);
         multigraph::MultiGraph edge_graph = vertex_graph.DBG();
         std::vector<Contig> contigs = edge_graph.getEdges(false);
-        auto res = PrintAlignments(logger, threads, contigs, reader.begin(), reader.end(), min_alignment, dir);
-        std::vector<Contig> uncompressed = Polish(logger, threads, contigs, res.first, reads, dicompress);
+        std::experimental::filesystem::path alignments = PrintAlignments(logger, threads, contigs, reader.begin(), reader.end(), min_alignment, dir);
+        std::vector<Contig> uncompressed = Polish(logger, threads, contigs, alignments, reads, dicompress);
         std::vector<Contig> assembly = printUncompressedResults(logger, threads, edge_graph, uncompressed, output_dir, debug);
         logger.info() << "Printing final assembly to " << (output_dir / "assembly.fasta") << std::endl;
         std::ofstream os_cut;
@@ -98,17 +98,23 @@ namespace multigraph {
                     if(tokens[4] == "-")
                         v2 = v2->rc;
                     size_t overlap = std::stoull(tokens[5].substr(0, tokens[5].size() - 1));
-                    if(v1->seq.Subseq(v1->seq.size() - overlap) != v2->seq.Subseq(0, overlap)) {
-                        v1 = v1->rc;
-                    }
-                    VERIFY(v1->seq.Subseq(v1->seq.size() - overlap) == v2->seq.Subseq(0, overlap));
-                    addEdge(*v1, *v2, v1->seq + v2->seq.Subseq(overlap));
+                    addLink(*v1, *v2, overlap);
                 }
             }
             is.close();
             return *this;
         }
 
+//        Adds an edge for a GFA link between oriented segments that overlap by overlap nucleotides
+        Edge &addLink(Vertex &from, Vertex &to, size_t overlap) {
+            Vertex *v1 = &from;
+            if(v1->seq.Subseq(v1->seq.size() - overlap) != to.seq.Subseq(0, overlap)) {
+                v1 = v1->rc;
+            }
+            VERIFY(v1->seq.Subseq(v1->seq.size() - overlap) == to.seq.Subseq(0, overlap));
+            return addEdge(*v1, to, v1->seq + to.seq.Subseq(overlap));
+        }
+
         MultiGraph DBG() const {
             MultiGraph dbg;
             std::unordered_map<Edge *, Vertex *> emap;
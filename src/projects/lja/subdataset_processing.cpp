@@ -6,9 +6,9 @@
 using namespace dbg;
 std::string RepeatResolver::COMMAND = "{} {} -i {} -o {} > {}";
 
-std::vector<RepeatResolver::Subdataset> RepeatResolver::SplitDataset(const std::function<bool(const Edge &)> &is_unique) {
+std::vector<RepeatResolver::Subdataset> RepeatResolver::SplitDataset(const std::function<bool(const Edge &)> &is_unique, size_t threads) {
     size_t k = dbg.hasher().getK();
-    std::vector<Component> comps = ConditionSplitter(is_unique).splitGraph(dbg);
+    std::vector<Component> comps = ConditionSplitter(is_unique, threads).splitGraph(dbg);
     std::vector<Subdataset> result;
     recreate_dir(dir);
     std::unordered_map<Vertex *, size_t> cmap;
@@ -134,7 +134,7 @@ std::vector<Contig> RepeatResolver::ProcessSubdataset(logging::Logger &logger, c
 std::vector<Contig> RepeatResolver::ResolveRepeats(logging::Logger &logger, size_t threads,
                                                    const std::function<bool(const Edge &)> &is_unique) {
     logger.info() << "Splitting dataset" << std::endl;
-    std::vector<Subdataset> subdatasets = SplitDataset(is_unique);
+    std::vector<Subdataset> subdatasets = SplitDataset(is_unique, threads);
     logger.info() << "Dataset splitted into " << subdatasets.size() << " parts. Starting resolution." << std::endl;
     logger.info() << "Running repeat resolution" << std::endl;
     std::sort(subdatasets.begin(), subdatasets.end());
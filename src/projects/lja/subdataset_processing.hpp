@@ -37,7 +37,7 @@ public:
             command_pattern = COMMAND.replace(COMMAND.find("{}"), 2, "--no_export_pdf");
     }
 
-    std::vector<Subdataset> SplitDataset(const std::function<bool(const dbg::Edge &)> &is_unique);
+    std::vector<Subdataset> SplitDataset(const std::function<bool(const dbg::Edge &)> &is_unique, size_t threads = 1);
     void prepareDataset(const Subdataset &subdataset);
     std::vector<Contig> ProcessSubdataset(logging::Logger &logger, const Subdataset &subdataset);
     std::vector<Contig> ResolveRepeats(logging::Logger &logger, size_t threads,
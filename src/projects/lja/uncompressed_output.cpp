@@ -3,6 +3,7 @@
 #include <sequences/edit_distance.hpp>
 #include <common/logging.hpp>
 #include <common/omp_utils.hpp>
+#include <common/parallel_output.hpp>
 #include <ksw2/ksw_wrapper.hpp>
 #include "multi_graph.hpp"
 
@@ -115,45 +116,111 @@ size_t rightHomoSize(const Sequence &s) {
     return homoSize(s, s.size() - 1);
 }
 
-std::vector<cigar_pair> UncompressOverlap(const Sequence &hpcOverlap, const Sequence &left, const Sequence & right) {
-    StringContig sc(left.str(), "left");
+//Part of the uncompressed incoming edge that corresponds to the compressed vertex sequence at its end
+Sequence IncomingOverlapEnd(const Sequence &hpcOverlap, const Sequence &left) {
     size_t left_len = compressedPrefixSize(!hpcOverlap, !left);
+    return left.Subseq(left.size() - left_len);
+}
+
+//Part of the uncompressed outgoing edge that corresponds to the compressed vertex sequence at its start
+Sequence OutgoingOverlapEnd(const Sequence &hpcOverlap, const Sequence &right) {
     size_t right_len = compressedPrefixSize(hpcOverlap, right);
-    Sequence left_seq = left.Subseq(left.size() - left_len);
-    Sequence right_seq = right.Subseq(0, right_len);
+    return right.Subseq(0, right_len);
+}
+
+//Aligns overlap ends of an incoming and an outgoing edge of the same vertex. Ends only depend on one edge each,
+//so they are computed once per edge and every distinct pair of ends is aligned once per vertex.
+//Ends can not be aligned to the vertex separately and combined per pair: both ends compress to the vertex sequence,
+//but the aligner prefers a mismatch to an insertion and a deletion in neighbouring homopolymers
+//(GTAACTT and GTACCTT align as 7M), so combining homopolymer lengths would change overlap cigars.
+std::vector<cigar_pair> AlignOverlapEnds(Sequence left_seq, Sequence right_seq) {
     if(leftHomoSize(left_seq) > leftHomoSize(right_seq)) {
         left_seq = left_seq.Subseq(leftHomoSize(left_seq) - leftHomoSize(right_seq));
     }
     if(rightHomoSize(left_seq) < rightHomoSize(right_seq)) {
         right_seq = right_seq.Subseq(0, right_seq.size() - (rightHomoSize(right_seq) - rightHomoSize(left_seq)));
     }
+    if(left_seq == right_seq) {
+        if(left_seq.empty())
+            return {};
+        return {cigar_pair('M', left_seq.size())};
+    }
     KSWAligner kswAligner(1, 5, 10, 2);
     return kswAligner.iterativeBandAlign(left_seq.str(), right_seq.str(), 5, 100, 0.01);
 }
 
+std::vector<cigar_pair> UncompressOverlap(const Sequence &hpcOverlap, const Sequence &left, const Sequence & right) {
+    return AlignOverlapEnds(IncomingOverlapEnd(hpcOverlap, left), OutgoingOverlapEnd(hpcOverlap, right));
+}
+
+//Index of the first sequence in seqs that is equal to each of them
+static std::vector<size_t> FirstEqual(const std::vector<Sequence> &seqs) {
+    std::vector<size_t> res(seqs.size());
+    for(size_t i = 0; i < seqs.size(); i++) {
+        res[i] = i;
+        for(size_t j = 0; j < i; j++) {
+            if(seqs[j] == seqs[i]) {
+                res[i] = j;
+                break;
+            }
+        }
+    }
+    return res;
+}
+
+//Edges and vertices of the graph are addressed by their ids shifted to be non-negative. Ids of reverse-complement
+//edges and vertices are negations of each other, so this gives dense indices without hash maps.
+static size_t EdgeIndex(const multigraph::MultiGraph &graph, const multigraph::Edge *edge) {
+    return size_t(edge->getId() + graph.maxEId);
+}
+
+static size_t VertexIndex(const multigraph::MultiGraph &graph, const multigraph::Vertex *vertex) {
+    return size_t(vertex->id + graph.maxVId);
+}
+
 std::vector<Contig> printUncompressedResults(logging::Logger &logger, size_t threads, multigraph::MultiGraph &graph,
                               const std::vector<Contig> &uncompressed, const std::experimental::filesystem::path &out_dir, bool debug) {
     logger.info() << "Calculating overlaps between adjacent uncompressed edges" << std::endl;
-    std::unordered_map<int, Sequence> uncompression_results;
+    std::vector<Sequence> uncompression_results(2 * graph.maxEId + 1);
     for(const Contig &contig : uncompressed) {
-        uncompression_results[std::stoi(contig.id)] = contig.seq;
-        uncompression_results[-std::stoi(contig.id)] = !contig.seq;
+        int id = std::stoi(contig.id);
+        uncompression_results[id + graph.maxEId] = contig.seq;
+        uncompression_results[-id + graph.maxEId] = !contig.seq;
     }
     ParallelRecordCollector<OverlapRecord> cigars_collection(threads);
     omp_set_num_threads(threads);
-#pragma omp parallel for default(none) shared(graph, cigars_collection, uncompression_results, logger, debug, std::cout)
+#pragma omp parallel for default(none) shared(graph, cigars_collection, uncompression_results, logger, debug, std::cout) schedule(dynamic, 16)
     for(size_t i = 0; i < graph.vertices.size(); i++) {
         multigraph::Vertex &vertex = *graph.vertices[i];
         if(!vertex.isCanonical())
             continue;
+        std::vector<Sequence> out_ends;
         for (multigraph::Edge *out_edge : vertex.outgoing) {
-            for (multigraph::Edge *inc_edge : vertex.rc->outgoing) {
-                VERIFY_OMP(out_edge->getSeq().startsWith(vertex.seq));
-                VERIFY_OMP(inc_edge->getSeq().startsWith(!vertex.seq));
-                std::vector<cigar_pair> cigar = UncompressOverlap(graph.vertices[i]->seq, uncompression_results[inc_edge->rc->getId()],
-                                                                  uncompression_results[out_edge->getId()]);
-                OverlapRecord overlapRecord(inc_edge->rc, out_edge, uncompression_results[inc_edge->rc->getId()],
-                                                                  uncompression_results[out_edge->getId()], cigar);
+            VERIFY_OMP(out_edge->getSeq().startsWith(vertex.seq));
+            out_ends.emplace_back(OutgoingOverlapEnd(vertex.seq, uncompression_results[EdgeIndex(graph, out_edge)]));
+        }
+        std::vector<Sequence> inc_ends;
+        for (multigraph::Edge *inc_edge : vertex.rc->outgoing) {
+            VERIFY_OMP(inc_edge->getSeq().startsWith(!vertex.seq));
+            inc_ends.emplace_back(IncomingOverlapEnd(vertex.seq, uncompression_results[EdgeIndex(graph, inc_edge->rc)]));
+        }
+        //Uncompressed ends of different edges often coincide, so every distinct pair of ends is aligned only once
+        std::vector<size_t> out_first = FirstEqual(out_ends);
+        std::vector<size_t> inc_first = FirstEqual(inc_ends);
+        std::vector<std::vector<cigar_pair>> aligned(inc_ends.size() * out_ends.size());
+        std::vector<bool> computed(aligned.size(), false);
+        for (size_t out_ind = 0; out_ind < vertex.outgoing.size(); out_ind++) {
+            multigraph::Edge *out_edge = vertex.outgoing[out_ind];
+            for (size_t inc_ind = 0; inc_ind < vertex.rc->outgoing.size(); inc_ind++) {
+                multigraph::Edge *inc_edge = vertex.rc->outgoing[inc_ind];
+                const Sequence &left = uncompression_results[EdgeIndex(graph, inc_edge->rc)];
+                const Sequence &right = uncompression_results[EdgeIndex(graph, out_edge)];
+                size_t key = inc_first[inc_ind] * out_ends.size() + out_first[out_ind];
+                if(!computed[key]) {
+                    aligned[key] = AlignOverlapEnds(inc_ends[inc_first[inc_ind]], out_ends[out_first[out_ind]]);
+                    computed[key] = true;
+                }
+                OverlapRecord overlapRecord(inc_edge->rc, out_edge, left, right, aligned[key]);
                 if(debug) {
 #pragma omp critical
                     {
@@ -166,57 +233,77 @@ std::vector<Contig> printUncompressedResults(logging::Logger &logger, size_t thr
             }
         }
     }
-    logger.info() << "Printing final gfa file to " << (out_dir / "mdbg.gfa") << std::endl;
-    std::ofstream os;
-    os.open(out_dir / "mdbg.gfa");
-    os << "H\tVN:Z:1.0" << std::endl;
-    std::unordered_map<multigraph::Edge *, std::string> eids;
+    std::vector<OverlapRecord> overlaps = cigars_collection.collect();
+    std::sort(overlaps.begin(), overlaps.end(), [](const OverlapRecord &a, const OverlapRecord &b) {
+        return std::make_pair(a.left->getId(), a.right->getId()) < std::make_pair(b.left->getId(), b.right->getId());
+    });
+    std::vector<multigraph::Edge *> canonical;
     for(multigraph::Edge *edge : graph.edges){
         if (edge->isCanonical()) {
-            os << "S\t" << itos(edge->getId()) << "\t" << uncompression_results[edge->getId()] << "\n";
+            canonical.emplace_back(edge);
         }
     }
-    for(OverlapRecord &rec : cigars_collection) {
+    logger.info() << "Printing final gfa file to " << (out_dir / "mdbg.gfa") << std::endl;
+    std::ofstream os;
+    os.open(out_dir / "mdbg.gfa");
+    os << "H\tVN:Z:1.0" << std::endl;
+    std::function<void(size_t, std::string &)> segment_task = [&graph, &canonical, &uncompression_results](size_t num, std::string &buffer) {
+        multigraph::Edge *edge = canonical[num];
+        buffer += "S\t";
+        buffer += itos(edge->getId());
+        buffer += "\t";
+        buffer += uncompression_results[EdgeIndex(graph, edge)].str();
+        buffer += "\n";
+    };
+    std::function<size_t(size_t)> segment_size = [&graph, &canonical, &uncompression_results](size_t num) {
+        return uncompression_results[EdgeIndex(graph, canonical[num])].size() + 20;
+    };
+    ParallelPrint(os, canonical.size(), threads, segment_task, segment_size);
+    std::function<void(size_t, std::string &)> link_task = [&overlaps](size_t num, std::string &buffer) {
+        const OverlapRecord &rec = overlaps[num];
         bool inc_sign = rec.left->isCanonical();
         int incId = inc_sign ? rec.left->getId() : rec.left->rc->getId();
         bool out_sign = rec.right->isCanonical();
         int outId = out_sign ? rec.right->getId() : rec.right->rc->getId();
-        os << "L\t" << incId << "\t" << (inc_sign ? "+" : "-") << "\t" << outId << "\t"
-           << (out_sign ? "+" : "-") << "\t" << rec.cigarString() << "\n";
-    }
+        buffer += "L\t";
+        buffer += itos(incId);
+        buffer += inc_sign ? "\t+\t" : "\t-\t";
+        buffer += itos(outId);
+        buffer += out_sign ? "\t+\t" : "\t-\t";
+        buffer += rec.cigarString();
+        buffer += "\n";
+    };
+    std::function<size_t(size_t)> link_size = [&overlaps](size_t num) {
+        return 30 + overlaps[num].cigar.size() * 4;
+    };
+    ParallelPrint(os, overlaps.size(), threads, link_task, link_size);
     os.close();
-    std::ofstream os_cut;
-    std::unordered_map<multigraph::Vertex *, size_t> cut; //Choice of vertex side for cutting
+    std::vector<size_t> cut(2 * graph.maxVId + 1); //Choice of vertex side for cutting
     for(multigraph::Vertex *v : graph.vertices) {
         if(v->seq <= !v->seq) {
             if(v->outDeg() == 1) {
-                cut[v] = 0;
+                cut[VertexIndex(graph, v)] = 0;
             } else {
-                cut[v] = 1;
+                cut[VertexIndex(graph, v)] = 1;
             }
-            cut[v->rc] = 1 - cut[v];
+            cut[VertexIndex(graph, v->rc)] = 1 - cut[VertexIndex(graph, v)];
         }
     }
-    std::unordered_map<multigraph::Edge*, size_t> cuts; //Sizes of cuts from the edge start
-    for(multigraph::Edge *e : graph.edges) {
-        cuts[e] = 0;
-    }
-    for(OverlapRecord &rec : cigars_collection) {
-        cuts[rec.left->rc] = cut[rec.left->rc->start] * rec.endSize();
-        cuts[rec.right] = cut[rec.right->start] * rec.startSize();
+    std::vector<size_t> cuts(2 * graph.maxEId + 1, 0); //Sizes of cuts from the edge start
+    for(OverlapRecord &rec : overlaps) {
+        cuts[EdgeIndex(graph, rec.left->rc)] = cut[VertexIndex(graph, rec.left->rc->start)] * rec.endSize();
+        cuts[EdgeIndex(graph, rec.right)] = cut[VertexIndex(graph, rec.right->start)] * rec.startSize();
     }
     std::vector<Contig> res;
-    for(multigraph::Edge *edge : graph.edges) {
-        if(edge->isCanonical()) {
-            //TODO make canonical be the same as positive id
-            size_t cut_left = cuts[edge];
-            size_t cut_right = cuts[edge->rc];
-            Sequence seq = uncompression_results[edge->getId()];
-            if(cut_left + cut_right >= seq.size()) {
-                continue;
-            }
-            res.emplace_back(seq.Subseq(cut_left, seq.size() - cut_right), itos(edge->getId()));
+    for(multigraph::Edge *edge : canonical) {
+        //TODO make canonical be the same as positive id
+        size_t cut_left = cuts[EdgeIndex(graph, edge)];
+        size_t cut_right = cuts[EdgeIndex(graph, edge->rc)];
+        const Sequence &seq = uncompression_results[EdgeIndex(graph, edge)];
+        if(cut_left + cut_right >= seq.size()) {
+            continue;
         }
+        res.emplace_back(seq.Subseq(cut_left, seq.size() - cut_right), itos(edge->getId()));
     }
     return std::move(res);
 }
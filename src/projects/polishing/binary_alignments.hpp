@@ -0,0 +1,231 @@
+#pragma once
+
+#include "common/verify.hpp"
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <experimental/filesystem>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * Binary hand-off of read to contig alignments between RealignReads and polishing.
+ * File layout:
+ *   Header
+ *   Record[record_count]                    sorted by read index
+ *   uint64_t[read_count + 1]                offsets of read names in read name characters
+ *   char[]                                  read name characters, padded to 8 bytes
+ *   uint64_t[contig_count + 1]              offsets of contig names in contig name characters
+ *   char[]                                  contig name characters
+ * All parts have fixed size once the record count and name lengths are known, so different threads write
+ * different parts of the file independently. The file is loaded with mmap and used in place.
+ */
+namespace binary_alignments {
+    const char MAGIC[8] = {'L', 'J', 'A', 'A', 'L', 'N', '0', '1'};
+
+    struct Header {
+        char magic[8];
+        uint64_t record_count;
+        uint64_t read_count;
+        uint64_t contig_count;
+    };
+
+    struct Record {
+        uint64_t read_index;
+        uint64_t contig_start;
+        uint64_t contig_end;
+        uint32_t read_start;
+        uint32_t read_end;
+        uint32_t contig_index;
+//Coordinates are given on the reverse complement strand of the contig
+        uint8_t rc;
+//Alignment does not reach either end of the read or contig on one of the sides
+        uint8_t partial;
+        uint16_t reserved;
+    };
+
+    static_assert(sizeof(Record) == 40, "Binary alignment record layout changed");
+
+    inline size_t Align(size_t offset) {
+        return (offset + 7) / 8 * 8;
+    }
+
+    inline void WriteAt(int fd, const char *data, size_t size, size_t offset) {
+        while(size > 0) {
+            ssize_t written = pwrite(fd, data, size, offset);
+            VERIFY_MSG(written > 0, "Failed to write binary alignments");
+            data += written;
+            size -= written;
+            offset += written;
+        }
+    }
+
+    //Names stored as a single character array with name boundaries, the same way they are laid out in the file
+    struct NameTable {
+        std::vector<uint64_t> offsets{0};
+        std::string chars;
+
+        void add(const std::string &name) {
+            chars += name;
+            offsets.push_back(chars.size());
+        }
+
+        size_t size() const {
+            return offsets.size() - 1;
+        }
+    };
+
+    //Non-owning access to alignment records and names that is shared by in-memory and mapped alignments
+    class AlignmentView {
+    private:
+        const Record *records = nullptr;
+        size_t record_count = 0;
+        const uint64_t *read_offsets = nullptr;
+        const char *read_chars = nullptr;
+        const uint64_t *contig_offsets = nullptr;
+        const char *contig_chars = nullptr;
+        size_t contig_count = 0;
+
+    public:
+        AlignmentView() = default;
+        AlignmentView(const Record *records, size_t record_count,
+                      const uint64_t *read_offsets, const char *read_chars,
+                      const uint64_t *contig_offsets, const char *contig_chars, size_t contig_count) :
+                records(records), record_count(record_count), read_offsets(read_offsets), read_chars(read_chars),
+                contig_offsets(contig_offsets), contig_chars(contig_chars), contig_count(contig_count) {
+        }
+
+        size_t size() const {
+            return record_count;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        size_t contigCount() const {
+            return contig_count;
+        }
+
+        const Record &operator[](size_t ind) const {
+            return records[ind];
+        }
+
+        std::string readName(size_t ind) const {
+            return {read_chars + read_offsets[ind], read_chars + read_offsets[ind + 1]};
+        }
+
+        std::string contigName(size_t ind) const {
+            return {contig_chars + contig_offsets[ind], contig_chars + contig_offsets[ind + 1]};
+        }
+    };
+
+    //Writes name table starting from offset and returns the aligned offset right after it
+    inline size_t WriteNames(int fd, const NameTable &names, size_t offset) {
+        WriteAt(fd, reinterpret_cast<const char *>(names.offsets.data()), names.offsets.size() * sizeof(uint64_t), offset);
+        offset += names.offsets.size() * sizeof(uint64_t);
+        WriteAt(fd, names.chars.data(), names.chars.size(), offset);
+        return Align(offset + names.chars.size());
+    }
+
+    //Alignments collected in memory. They are handed to polishing directly and written to disk only on request.
+    struct AlignmentStorage {
+        std::vector<Record> records;
+        NameTable read_names;
+        NameTable contig_names;
+
+        AlignmentView view() const {
+            return {records.data(), records.size(), read_names.offsets.data(), read_names.chars.data(),
+                    contig_names.offsets.data(), contig_names.chars.data(), contig_names.size()};
+        }
+
+        void Write(const std::experimental::filesystem::path &fname) const {
+            int fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            VERIFY_MSG(fd >= 0, "Could not open file " + fname.string() + " for writing");
+            Header header{};
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.record_count = records.size();
+            header.read_count = read_names.size();
+            header.contig_count = contig_names.size();
+            WriteAt(fd, reinterpret_cast<const char *>(&header), sizeof(Header), 0);
+            size_t records_offset = sizeof(Header);
+            size_t names_offset = records_offset + records.size() * sizeof(Record);
+#pragma omp parallel default(none) shared(fd, records_offset, names_offset)
+            {
+                size_t nthreads = omp_get_num_threads();
+                size_t left = records.size() * omp_get_thread_num() / nthreads;
+                size_t right = records.size() * (omp_get_thread_num() + 1) / nthreads;
+                WriteAt(fd, reinterpret_cast<const char *>(records.data() + left), (right - left) * sizeof(Record),
+                        records_offset + left * sizeof(Record));
+#pragma omp single nowait
+                {
+                    WriteNames(fd, contig_names, WriteNames(fd, read_names, names_offset));
+                }
+            }
+            close(fd);
+        }
+    };
+
+    class AlignmentFile {
+    private:
+        int fd = -1;
+        size_t file_size = 0;
+        const char *data = nullptr;
+        AlignmentView alignments;
+
+        //Returns the end of a section of count elements that starts at offset. Fails if the section does not fit
+        //into the file, so that offsets stored at the end of a section are only read after the section is checked.
+        size_t SectionEnd(size_t offset, size_t count, size_t element_size, const std::string &message) const {
+            VERIFY_MSG(offset <= file_size && count <= (file_size - offset) / element_size, message);
+            return offset + count * element_size;
+        }
+
+    public:
+        explicit AlignmentFile(const std::experimental::filesystem::path &fname) {
+            fd = open(fname.c_str(), O_RDONLY);
+            VERIFY_MSG(fd >= 0, "Could not open alignment file " + fname.string());
+            struct stat st{};
+            fstat(fd, &st);
+            file_size = st.st_size;
+            VERIFY_MSG(file_size >= sizeof(Header), "Alignment file " + fname.string() + " is truncated");
+            void *addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            VERIFY_MSG(addr != MAP_FAILED, "Could not map alignment file " + fname.string());
+            madvise(addr, file_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(addr);
+            const Header *header = reinterpret_cast<const Header *>(data);
+            VERIFY_MSG(memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0,
+                       "File " + fname.string() + " is not an LJA binary alignment file");
+            std::string truncated = "Alignment file " + fname.string() + " is truncated";
+            VERIFY_MSG(header->read_count < file_size && header->contig_count < file_size, truncated);
+            size_t records_offset = sizeof(Header);
+            size_t read_offsets_offset = SectionEnd(records_offset, header->record_count, sizeof(Record), truncated);
+            size_t read_chars_offset = SectionEnd(read_offsets_offset, header->read_count + 1, sizeof(uint64_t), truncated);
+            const uint64_t *read_offsets = reinterpret_cast<const uint64_t *>(data + read_offsets_offset);
+            size_t contig_offsets_offset = Align(SectionEnd(read_chars_offset, read_offsets[header->read_count], 1, truncated));
+            size_t contig_chars_offset = SectionEnd(contig_offsets_offset, header->contig_count + 1, sizeof(uint64_t), truncated);
+            const uint64_t *contig_offsets = reinterpret_cast<const uint64_t *>(data + contig_offsets_offset);
+            SectionEnd(contig_chars_offset, contig_offsets[header->contig_count], 1, truncated);
+            const Record *records = reinterpret_cast<const Record *>(data + records_offset);
+            const char *read_chars = data + read_chars_offset;
+            const char *contig_chars = data + contig_chars_offset;
+            alignments = {records, header->record_count, read_offsets, read_chars,
+                          contig_offsets, contig_chars, header->contig_count};
+        }
+
+        AlignmentFile(const AlignmentFile &) = delete;
+        AlignmentFile &operator=(const AlignmentFile &) = delete;
+
+        ~AlignmentFile() {
+            munmap(const_cast<char *>(data), file_size);
+            close(fd);
+        }
+
+        const AlignmentView &view() const {
+            return alignments;
+        }
+    };
+}
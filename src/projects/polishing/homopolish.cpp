@@ -10,6 +10,7 @@
 #include <vector>
 #include <iostream>
 #include <array>
+#include <numeric>
 #include <spoa/spoa.hpp>
 #include <ksw2/ksw_wrapper.hpp>
 
@@ -84,15 +85,37 @@ vector<dinucleotide> GetDinucleotideRepeats(const Contig& compressed_contig) {
     return res;
 }
 
+//Homopolymer length votes for a single position packed into 4-bit cells.
+//Lengths that do not fit into a cell are marked with OVERFLOW and stored separately by the contig.
+struct PackedVotes {
+    static constexpr size_t VOTES_STORED = 21;
+    static constexpr uint8_t OVERFLOW = 15;
+    uint8_t size = 0;
+    array<uint8_t, (VOTES_STORED + 1) / 2> cells{};
+
+    uint8_t get(size_t i) const {
+        return (cells[i / 2] >> (4 * (i % 2))) & 15u;
+    }
+
+    void push(uint8_t val) {
+        cells[size / 2] |= uint8_t((val < OVERFLOW ? val : OVERFLOW) << (4 * (size % 2)));
+        size++;
+    }
+
+    bool full() const {
+        return size == VOTES_STORED;
+    }
+};
+
 struct ContigInfo {
     string sequence;
     string name;
     size_t len = 0;
     vector<uint8_t > quantity;
-//array size. possibly switch to []
-    static const size_t VOTES_STORED = 21;
-    //To avoid multiple resizes real length stored in first element of each vector
-    vector<array<uint8_t, VOTES_STORED + 1>> amounts;
+    static const size_t VOTES_STORED = PackedVotes::VOTES_STORED;
+    vector<PackedVotes> amounts;
+//Votes that are too large for PackedVotes cells in the order they were added. Long homopolymers are rare.
+    std::unordered_map<size_t, vector<uint8_t>> long_amounts;
     vector<uint16_t> sum;
     size_t zero_covered = 0;
 //neighbourhoud for complex regions;
@@ -140,11 +163,30 @@ struct ContigInfo {
         for (size_t i = 0; i < len; i ++){
             sum[i] = 0;
             quantity[i] = 0;
-//            amounts[i].resize(VOTES_STORED + 1);
-            amounts[i][0] = 0;
         }
         FillComplex();
     }
+
+    void addVote(size_t coord, uint8_t val) {
+        if (amounts[coord].full())
+            return;
+        if (val >= PackedVotes::OVERFLOW)
+            long_amounts[coord].push_back(val);
+        amounts[coord].push(val);
+    }
+
+    uint8_t medianVote(size_t coord) {
+        array<uint8_t, VOTES_STORED> votes{};
+        size_t real_len = amounts[coord].size;
+        size_t overflow_ind = 0;
+        for (size_t j = 0; j < real_len; j++) {
+            votes[j] = amounts[coord].get(j);
+            if (votes[j] == PackedVotes::OVERFLOW)
+                votes[j] = long_amounts[coord][overflow_ind++];
+        }
+        sort(votes.begin(), votes.begin() + real_len);
+        return votes[(1 + real_len) / 2 - 1];
+    }
     ContigInfo() = default;
 
     size_t get_finish(const dinucleotide& d) {
@@ -292,9 +334,7 @@ struct ContigInfo {
                 if (quantity[i] == 0) {
                     zero_covered++;
                 } else {
-                    size_t real_len =  amounts[i][0];
-                    sort(amounts[i].begin() + 1, amounts[i].begin() + 1 + real_len);
-                    real_cov = amounts[i][(1 + real_len)/2];
+                    real_cov = medianVote(i);
 
                     cov = int(round(sum[i] * 1.0 / quantity[i]));
                     if (real_cov != cov) {
@@ -321,9 +361,13 @@ struct ContigInfo {
 };
 
 struct AssemblyInfo {
+    const std::vector<Contig> &assembly;
+//Contigs of the window that is currently polished
     std::map<string, ContigInfo> contigs;
 //dinucleotide repeats of larger length will be compressed
     size_t compression_length;
+//Maximal total length of contigs for which votes are stored simultaneously
+    size_t window_length;
 
     static const size_t SW_BANDWIDTH = 10;
 
@@ -332,17 +376,9 @@ struct AssemblyInfo {
 
     static const size_t BATCH_SIZE = 100000;
 
-    explicit AssemblyInfo (logging::Logger &logger,
-                           const std::vector<Contig> &assembly,
-                           size_t dicompress) {
-//TODO paths;
-
-        for (const auto& contig: assembly) {
-//TODO switch to Contig()
-            contigs.emplace(contig.id, ContigInfo(contig.seq.str(), contig.id));
-            logger.debug() << contig.id << endl;
-        }
-        compression_length= dicompress;
+    explicit AssemblyInfo (const std::vector<Contig> &assembly,
+                           size_t dicompress, size_t window_length) :
+                           assembly(assembly), compression_length(dicompress), window_length(window_length) {
     }
 
 //    void AddRead(const string& contig_name){
@@ -350,19 +386,16 @@ struct AssemblyInfo {
 //    }
 
 
-    AlignmentInfo readAlignment(std::ifstream &ss){
+    AlignmentInfo readAlignment(const binary_alignments::AlignmentView &alignments, size_t ind){
+        const binary_alignments::Record &rec = alignments[ind];
         AlignmentInfo res;
-        if (ss.eof())
-            return res;
-        ss >> res.read_id >> res.read_start >> res.read_end >>res.contig_id >> res.alignment_start>>res.alignment_end;
-
-        if (res.contig_id[0] == '-') {
-            res.contig_id = res.contig_id.substr(1);
-            res.rc = true;
-        } else {
-            res.rc = false;
-        }
-
+        res.read_id = alignments.readName(rec.read_index);
+        res.contig_id = alignments.contigName(rec.contig_index);
+        res.read_start = rec.read_start;
+        res.read_end = rec.read_end;
+        res.alignment_start = rec.contig_start;
+        res.alignment_end = rec.contig_end;
+        res.rc = rec.rc;
         return res;
     }
 
@@ -611,10 +644,7 @@ struct AssemblyInfo {
                         {
                             current_contig.quantity[coord]++;
                             current_contig.sum[coord] += quantities[read_coords + i];
-                            if (current_contig.amounts[coord][0] < ContigInfo::VOTES_STORED)
-//#pragma omp critical
-                                current_contig.amounts[coord][++current_contig.amounts[coord][0]] = quantities[
-                                        read_coords + i];
+                            current_contig.addVote(coord, quantities[read_coords + i]);
                         }
                         matches ++;
                     } else {
@@ -658,28 +688,79 @@ struct AssemblyInfo {
         }
     }
 
+//Contigs are split into windows of bounded total length. Alignments and reads are streamed once per window and
+//only alignments to contigs of the current window are processed. Window votes are released after consensus is built.
     vector<Contig> process(logging::Logger &logger, const io::Library &lib,
-                           const std::experimental::filesystem::path &alignmens_file) {
-        std::ifstream compressed_reads;
-        std::ofstream corrected_contigs;
-        compressed_reads.open(alignmens_file);
-        io::SeqReader reader(lib);
-        logger.trace() << "Initialized\n";
-        if (compressed_reads.eof()) {
+                           const binary_alignments::AlignmentView &alignments) {
+        if (alignments.empty()) {
             logger.info() << "NO ALIGNMENTS AVAILABLE!";
             exit(1);
         }
-        AlignmentInfo cur_align = readAlignment(compressed_reads);
-        string cur_compressed = cur_align.read_id;
-        string cur_read;
-        string cur_seq;
+        vector<size_t> order(assembly.size());
+        std::iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [this](size_t a, size_t b) {return assembly[a].id < assembly[b].id;});
+        vector<Contig> res;
+        size_t total_zero_covered = 0;
+        size_t window_num = 0;
+        size_t left = 0;
+        while (left < order.size()) {
+            size_t right = left;
+            size_t total_len = 0;
+            while (right < order.size() && (right == left || total_len + assembly[order[right]].size() <= window_length)) {
+//TODO switch to Contig()
+                const Contig &contig = assembly[order[right]];
+                contigs.emplace(contig.id, ContigInfo(contig.seq.str(), contig.id));
+                logger.debug() << contig.id << endl;
+                total_len += contig.size();
+                right++;
+            }
+            window_num++;
+            logger.info() << "Polishing window " << window_num << " of " << right - left << " contigs with total length "
+                          << total_len << endl;
+            processWindow(logger, lib, alignments);
+            logger.info() << "Uncompressing homopolymers in contigs" << endl;
+            for (auto& contig: contigs){
+                logger.trace() << "Generating consensus for contig " << contig.first << endl;
+                res.emplace_back(Sequence(contig.second.GenerateConsensus(logger)), contig.first);
+                total_zero_covered += contig.second.zero_covered;
+            }
+            contigs.clear();
+            left = right;
+        }
+        logger.info() << "Total zero covered nucleotides "  << total_zero_covered << endl;
+        return std::move(res);
+    }
+
+//Reads are streamed from the start of the library for every window. The reader only advances to reads that have
+//alignments to contigs of the window, so reads after the last such read are not parsed.
+    void processWindow(logging::Logger &logger, const io::Library &lib,
+                       const binary_alignments::AlignmentView &alignments) {
+        io::SeqReader reader(lib);
+        logger.trace() << "Initialized\n";
+        vector<bool> in_window(alignments.contigCount());
+        for (size_t i = 0; i < alignments.contigCount(); i++) {
+            in_window[i] = contigs.find(alignments.contigName(i)) != contigs.end();
+        }
         StringContig cur;
         logger.info() << "Reading and processing initial reads from " << lib << "\n";
         size_t reads_count = 0;
-        size_t aln_count = 1;
+        size_t aln_count = 0;
         vector<AlignmentInfo> align_batch;
         vector<string> contig_batch;
-        while (!compressed_reads.eof()) {
+        size_t ind = 0;
+        while (ind < alignments.size()) {
+            size_t read_index = alignments[ind].read_index;
+            size_t next = ind;
+            bool used = false;
+            while (next < alignments.size() && alignments[next].read_index == read_index) {
+                used |= !alignments[next].partial && in_window[alignments[next].contig_index];
+                next++;
+            }
+            if (!used) {
+                ind = next;
+                continue;
+            }
+            string cur_compressed = alignments.readName(read_index);
             bool reads_over = false;
             while (cur.id != cur_compressed) {
                 if (reader.eof()) {
@@ -698,53 +779,50 @@ struct AssemblyInfo {
             if (reads_over) {
                 break;
             }
-            align_batch.push_back(cur_align);
-            contig_batch.push_back(cur.seq);
 //TODO:: appropriate logic for multiple alignment
-            do {
-                cur_align = readAlignment(compressed_reads);
+            for (; ind < next; ind++) {
                 aln_count ++;
-                if (aln_count % BATCH_SIZE == 0) {
+                if (alignments[ind].partial || !in_window[alignments[ind].contig_index])
+                    continue;
+                align_batch.push_back(readAlignment(alignments, ind));
+                contig_batch.push_back(cur.seq);
+                if (align_batch.size() >= BATCH_SIZE) {
                     logger.trace() << "Batch of size " <<BATCH_SIZE <<" created, processing" << endl;
                     processBatch(logger, contig_batch, align_batch);
 
                     logger.trace() << "Processed " << aln_count << " compressed mappings " << endl;
                     contig_batch.resize(0);
                     align_batch.resize(0);
-                    //exit(0);
                 }
-
-                if (cur_compressed == cur_align.read_id) {
-                    align_batch.push_back(cur_align);
-                    contig_batch.push_back(cur.seq);
-                }
-            } while (cur_compressed == cur_align.read_id);
-            cur_compressed = cur_align.read_id;
+            }
         }
         processBatch(logger, contig_batch, align_batch);
         logger.trace() << "Processed final batch of " << align_batch.size() << " compressed reads " << endl;
-        vector<Contig> res;
-        logger.info() << "Uncompressing homopolymers in contigs" << endl;
-        for (auto& contig: contigs){
-            logger.trace() << "Generating consensus for contig " << contig.first << endl;
-            res.emplace_back(Sequence(contig.second.GenerateConsensus(logger)), contig.first);
-        }
-        size_t total_zero_covered = 0;
-        for (auto & contig: contigs) {
-            total_zero_covered += contig.second.zero_covered;
-        }
-        logger.info() << "Total zero covered nucleotides "  << total_zero_covered << endl;
-        return std::move(res);
     }
 };
 
+size_t PolishingWindow(size_t memory_limit) {
+    if(memory_limit == 0)
+        return 1000000000;
+//    Votes, coverage, vote sum and sequence stored for every position of a contig in the window
+    size_t bytes_per_position = sizeof(PackedVotes) + sizeof(uint8_t) + sizeof(uint16_t) + sizeof(char);
+    return std::max<size_t>(1, memory_limit / 4 / bytes_per_position);
+}
+
+std::vector<Contig> Polish(logging::Logger &logger, size_t threads,
+                           const std::vector<Contig> &contigs,
+                           const binary_alignments::AlignmentView &alignments,
+                           const io::Library &reads, size_t dicompress, size_t window_length) {
+    omp_set_num_threads(threads);
+    AssemblyInfo assemblyInfo(contigs, dicompress, window_length);
+    return std::move(assemblyInfo.process(logger, reads, alignments));
+}
 
 std::vector<Contig> Polish(logging::Logger &logger, size_t threads,
                                            const std::vector<Contig> &contigs,
                                            const std::experimental::filesystem::path &alignments,
-                                           const io::Library &reads, size_t dicompress) {
-    omp_set_num_threads(threads);
-    AssemblyInfo assemblyInfo(logger, contigs, dicompress);
-    return std::move(assemblyInfo.process(logger, reads, alignments));
+                                           const io::Library &reads, size_t dicompress, size_t window_length) {
+    binary_alignments::AlignmentFile alignment_file(alignments);
+    return Polish(logger, threads, contigs, alignment_file.view(), reads, dicompress, window_length);
 }
 
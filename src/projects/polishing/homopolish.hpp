@@ -2,7 +2,25 @@
 
 #include <sequences/seqio.hpp>
 #include "common/logging.hpp"
+#include "binary_alignments.hpp"
+
+//Window length for which votes of all contigs in the window take at most a quarter of memory_limit bytes.
+//Without a limit the whole assembly is polished in a single window.
+size_t PolishingWindow(size_t memory_limit);
+
+//Polishes contigs using alignments that are already in memory, e.g. collected with CollectAlignments.
+//Contigs are polished in windows of at most window_length total length to bound memory used for votes.
+//Every window streams the read library again up to the last read aligned to one of its contigs, so with n windows
+//reads are parsed up to n times. The default window covers the whole assembly and reads are parsed once.
+std::vector<Contig> Polish(logging::Logger &logger, size_t threads,
+                           const std::vector<Contig> &contigs,
+                           const binary_alignments::AlignmentView &alignments,
+                           const io::Library &reads, size_t dicompress,
+                           size_t window_length = 1000000000);
+
+//Polishes contigs using alignments stored in a file written by PrintAlignments. Windows work as above.
 std::vector<Contig> Polish(logging::Logger &logger, size_t threads,
                                            const std::vector<Contig> &contigs_file,
                                            const std::experimental::filesystem::path &alignments,
-                                           const io::Library &reads, size_t dicompress);
+                                           const io::Library &reads, size_t dicompress,
+                                           size_t window_length = 1000000000);
@@ -1,3 +1,4 @@
+#include "binary_alignments.hpp"
 #include <common/omp_utils.hpp>
 #include "sequences/contigs.hpp"
 #include "common/rolling_hash.hpp"
@@ -98,38 +99,59 @@ std::vector<AlignmentRecord> RealignReads(logging::Logger &logger, size_t thread
     return std::move(final);
 }
 
+//Realigns reads to contigs and both strands of contigs and packs the result into records that are handed to polishing.
 template<class I>
-std::pair<std::experimental::filesystem::path, std::experimental::filesystem::path>
-        PrintAlignments(logging::Logger &logger, size_t threads, const std::vector<Contig> &contigs, I read_start, I read_end, size_t K,
-                     const std::experimental::filesystem::path &dir) {
-    ensure_dir_existance(dir);
+binary_alignments::AlignmentStorage CollectAlignments(logging::Logger &logger, size_t threads, const std::vector<Contig> &contigs,
+                                                      I read_start, I read_end, size_t K) {
     std::vector<Contig> contigsAndRC;
     for(const Contig & contig : contigs) {
         contigsAndRC.emplace_back(contig);
         contigsAndRC.emplace_back(contig.RC());
     }
     std::vector<AlignmentRecord> final = RealignReads(logger, threads, contigsAndRC, read_start, read_end, K);
-    logger.info() << "Printing alignments to " << (dir/"alignments.txt") << std::endl;
-    std::experimental::filesystem::path good_fname = dir/"good_alignments.txt";
-    std::experimental::filesystem::path bad_fname = dir/"partial_alignments.txt";
-    std::ofstream os;
-    std::ofstream os_bad;
-    os.open(good_fname);
-    os_bad.open(bad_fname);
-    for(auto &rec : final) {
+    binary_alignments::AlignmentStorage res;
+    std::vector<size_t> read_index(final.size());
+    for(size_t i = 0; i < final.size(); i++) {
+        if(i == 0 || final[i].readIntId != final[i - 1].readIntId)
+            res.read_names.add(final[i].seg_from.id);
+        read_index[i] = res.read_names.size() - 1;
+    }
+    for(const Contig &contig : contigs) {
+        res.contig_names.add(contig.getId());
+    }
+    std::vector<binary_alignments::Record> &records = res.records;
+    records.resize(final.size());
+    omp_set_num_threads(threads);
+#pragma omp parallel for default(none) shared(final, records, read_index, contigsAndRC)
+    for(size_t i = 0; i < final.size(); i++) {
+        const AlignmentRecord &rec = final[i];
         size_t len = rec.contig_len;
-        if((rec.seg_from.left != 0 && rec.seg_to.left != 0) ||
-           (rec.seg_from.right != len && rec.seg_to.right != rec.seg_to.contig().size())) {
-            os_bad << rec.seg_from.id << " " << rec.seg_from.left << " " << rec.seg_from.right << " "
-                   << rec.seg_to.contig().getId() << " " << rec.seg_to.left << " " << rec.seg_to.right
-                   << "\n";
-        } else {
-            os << rec.seg_from.id << " " << rec.seg_from.left << " " << rec.seg_from.right << " "
-               << rec.seg_to.contig().getId() << " " << rec.seg_to.left << " " << rec.seg_to.right
-               << "\n";
-        }
+        size_t contig_ind = &rec.seg_to.contig() - contigsAndRC.data();
+        binary_alignments::Record &bin = records[i];
+        bin.read_index = read_index[i];
+        bin.read_start = rec.seg_from.left;
+        bin.read_end = rec.seg_from.right;
+        bin.contig_start = rec.seg_to.left;
+        bin.contig_end = rec.seg_to.right;
+        bin.contig_index = contig_ind / 2;
+        bin.rc = contig_ind % 2;
+        bin.partial = (rec.seg_from.left != 0 && rec.seg_to.left != 0) ||
+                      (rec.seg_from.right != len && rec.seg_to.right != rec.seg_to.contig().size());
+        bin.reserved = 0;
     }
-    os.close();
-    os_bad.close();
-    return {good_fname, bad_fname};
-}
\ No newline at end of file
+    return std::move(res);
+}
+
+//Alignments are stored in binary format described in binary_alignments.hpp. Records are written
+//by all threads independently.
+template<class I>
+std::experimental::filesystem::path PrintAlignments(logging::Logger &logger, size_t threads, const std::vector<Contig> &contigs,
+                                                    I read_start, I read_end, size_t K,
+                                                    const std::experimental::filesystem::path &dir) {
+    ensure_dir_existance(dir);
+    binary_alignments::AlignmentStorage alignments = CollectAlignments(logger, threads, contigs, read_start, read_end, K);
+    std::experimental::filesystem::path fname = dir/"alignments.bin";
+    logger.info() << "Printing alignments to " << fname << std::endl;
+    alignments.Write(fname);
+    return fname;
+}
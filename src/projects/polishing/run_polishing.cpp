@@ -2,13 +2,11 @@
 #include "homopolish.hpp"
 
 /*
- * я выдам записи вида read_id contig_id alignment_start alignment_end
-При этом прикладывания на другой стренд будут закодированы в contig_id. К нему в начале будет добавлен "-"
-и позиции будут как в реверс комплиментарной строке, а не как в исходной
- *
+ * Alignments are expected in the binary format written by PrintAlignments (see binary_alignments.hpp).
+ * Alignments to the other strand have rc flag set and their positions are given in the reverse complement contig.
  */
 int main(int argc, char **argv) {
-    CLParser parser({"alignments=", "contigs=", "output=", "debug=none", "threads=8", "compress=16"}, {"reads"},
+    CLParser parser({"alignments=", "contigs=", "output=", "debug=none", "threads=8", "compress=16", "window-length=1000000000"}, {"reads"},
                     {});
 
     parser.parseCL(argc, argv);
@@ -27,11 +25,12 @@ int main(int argc, char **argv) {
     omp_set_num_threads(stoi(parser.getValue("threads")));
     size_t dicompress = std::stoull(parser.getValue("compress"));
     size_t threads = std::stoull(parser.getValue("threads"));
+    size_t window_length = std::stoull(parser.getValue("window-length"));
     std::experimental::filesystem::path contigs_file(parser.getValue("contigs"));
     std::experimental::filesystem::path alignments_file(parser.getValue("alignments"));
     io::Library reads_lib = oneline::initialize<std::experimental::filesystem::path>(parser.getListValue("reads"));
     std::vector<Contig> assembly = io::SeqReader(contigs_file).readAllContigs();
-    std::vector<Contig> res = Polish(logger, threads, assembly, alignments_file, reads_lib, dicompress);
+    std::vector<Contig> res = Polish(logger, threads, assembly, alignments_file, reads_lib, dicompress, window_length);
     std::ofstream res_os;
     res_os.open(dir / "corrected_contigs.fasta");
     for(Contig &contig : res) {
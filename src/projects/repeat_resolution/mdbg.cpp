@@ -3,6 +3,7 @@
 //
 
 #include "mdbg.hpp"
+#include "common/parallel_output.hpp"
 
 using namespace repeat_resolution;
 
@@ -352,22 +353,18 @@ void MultiplexDBG::ExportToGFA(
     const std::unordered_map<RREdgeIndexType, bool> edge_can =
         AreSeqsCanonical<RREdgeIndexType>(edge_seqs);
 
-    ExportToGFA(path, vertex_seqs, edge_seqs, vertex2rc, edge2rc, vertex_can,
-                edge_can);
+    GetGFA(edge_seqs, vertex2rc, edge2rc, vertex_can, edge_can)
+        .Write(path, threads);
 }
 
-void MultiplexDBG::ExportToGFA(
-    const std::experimental::filesystem::path &path,
-    const std::unordered_map<RRVertexType, Sequence> &vertex_seqs,
+GFAGraph MultiplexDBG::GetGFA(
     const std::unordered_map<RREdgeIndexType, Sequence> &edge_seqs,
     const std::unordered_map<RRVertexType, RRVertexType> &vertex2rc,
     const std::unordered_map<RREdgeIndexType, RREdgeIndexType> &edge2rc,
     const std::unordered_map<RRVertexType, bool> &vertex_can,
     const std::unordered_map<RREdgeIndexType, bool> &edge_can) const {
 
-    std::ofstream os;
-    os.open(path);
-    os << "H\tVN:Z:1.0" << std::endl;
+    GFAGraph gfa;
     std::unordered_map<RREdgeIndexType, RREdgeIndexType> edge2can_id;
     for (auto v_it = begin(); v_it!=end(); ++v_it) {
         auto[begin, end] = out_neighbors(v_it);
@@ -377,7 +374,7 @@ void MultiplexDBG::ExportToGFA(
             if (edge_can.at(e_ind)) {
                 edge2can_id.emplace(e_ind, e_ind);
                 edge2can_id.emplace(edge2rc.at(e_ind), e_ind);
-                os << "S\t" << e_ind << "\t" << edge_seqs.at(e_ind) << "\n";
+                gfa.segments.emplace_back(e_ind, edge_seqs.at(e_ind));
             }
         }
     }
@@ -400,13 +397,39 @@ void MultiplexDBG::ExportToGFA(
                 const RREdgeIndexType in_ind = in_prop.Index();
                 bool in_sign = not edge_can.at(in_ind);
                 const RREdgeIndexType in_can_ind = edge2can_id.at(in_ind);
-                os << "L\t" << in_can_ind << "\t" << (in_sign ? "+" : "-")
-                   << "\t"
-                   << out_can_ind << "\t" << (out_sign ? "+" : "-") << "\t"
-                   << node_prop(v_it).size() << "M\n";
+                gfa.links.push_back({in_can_ind, in_sign, out_can_ind, out_sign,
+                                     node_prop(v_it).size()});
             }
         }
     }
+    return gfa;
+}
+
+void GFAGraph::Write(const std::experimental::filesystem::path &path,
+                     size_t threads) const {
+    std::ofstream os;
+    os.open(path);
+    os << "H\tVN:Z:1.0" << std::endl;
+    std::function<void(size_t, std::string &)> segment_task =
+        [this](size_t num, std::string &buffer) {
+          buffer += "S\t";
+          buffer += std::to_string(segments[num].first);
+          buffer += "\t";
+          segments[num].second.appendStr(buffer);
+          buffer += "\n";
+        };
+    std::function<size_t(size_t)> segment_size =
+        [this](size_t num) {
+          return segments[num].second.size() + 30;
+        };
+    ParallelPrint(os, segments.size(), threads, segment_task, segment_size);
+
+    for (const Link &link : links) {
+        os << "L\t" << link.from << "\t" << (link.from_forward ? "+" : "-")
+           << "\t"
+           << link.to << "\t" << (link.to_forward ? "+" : "-") << "\t"
+           << link.overlap << "M\n";
+    }
 }
 
 [[nodiscard]] bool MultiplexDBG::IsFrozen() const {
@@ -799,19 +822,29 @@ std::vector<Contig> MultiplexDBG::ExportContigs(
     const std::unordered_map<RREdgeIndexType, Sequence> &edge_seqs,
     const std::unordered_map<RRVertexType, RRVertexType> &vertex2rc,
     const std::unordered_map<RRVertexType, bool> &vertex_can,
-    const std::unordered_map<RREdgeIndexType, bool> &edge_can) const {
+    const std::unordered_map<RREdgeIndexType, bool> &edge_can,
+    size_t threads) const {
     std::ofstream os;
     os.open(f);
     std::vector<Contig> edges =
         GetContigs(vertex_seqs, edge_seqs, vertex2rc, vertex_can, edge_can);
-    for (const Contig &contig : edges) {
-        os << ">" << contig.id << "\n" << contig.seq << "\n";
-    }
+    std::function<void(size_t, std::string &)> contig_task =
+        [&edges](size_t num, std::string &buffer) {
+          buffer += ">";
+          buffer += edges[num].id;
+          buffer += "\n";
+          edges[num].seq.appendStr(buffer);
+          buffer += "\n";
+        };
+    std::function<size_t(size_t)> contig_size = [&edges](size_t num) {
+      return edges[num].size() + edges[num].id.size() + 3;
+    };
+    ParallelPrint(os, edges.size(), threads, contig_task, contig_size);
     os.close();
     return edges;
 }
 
-std::vector<Contig> MultiplexDBG::ExportContigsAndGFA(
+GFAGraph MultiplexDBG::ExportContigsAndGFA(
     const std::experimental::filesystem::path &contigs_fn,
     const std::experimental::filesystem::path &gfa_fn, size_t threads) const {
 
@@ -830,10 +863,13 @@ std::vector<Contig> MultiplexDBG::ExportContigsAndGFA(
     std::unordered_map<RREdgeIndexType, bool> edge_can =
         AreSeqsCanonical<RREdgeIndexType>(edge_seqs);
 
-    ExportToGFA(gfa_fn, vertex_seqs, edge_seqs, vertex2rc, edge2rc, vertex_can,
-                edge_can);
-    return ExportContigs(contigs_fn, vertex_seqs, edge_seqs, vertex2rc,
-                         vertex_can, edge_can);
+    GFAGraph gfa = GetGFA(edge_seqs, vertex2rc, edge2rc, vertex_can, edge_can);
+    if (!gfa_fn.empty()) {
+        gfa.Write(gfa_fn, threads);
+    }
+    ExportContigs(contigs_fn, vertex_seqs, edge_seqs, vertex2rc, vertex_can,
+                  edge_can, threads);
+    return gfa;
 }
 
 void MultiplexDBG::ExportActiveTransitions(
@@ -10,6 +10,25 @@
 
 namespace repeat_resolution {
 
+// Resolved graph in the form it is exported to GFA. Segments are canonical
+// edges and links connect oriented segments through vertices. Both are kept in
+// the order they are written, so the graph can be handed to later stages
+// without writing and parsing the GFA file.
+struct GFAGraph {
+    struct Link {
+        RREdgeIndexType from;
+        bool from_forward;
+        RREdgeIndexType to;
+        bool to_forward;
+        uint64_t overlap;
+    };
+    std::vector<std::pair<RREdgeIndexType, Sequence>> segments;
+    std::vector<Link> links;
+
+    void Write(const std::experimental::filesystem::path &path,
+               size_t threads) const;
+};
+
 class MultiplexDBG
     : public graph_lite::Graph<
         /*typename NodeType=*/RRVertexType,
@@ -49,9 +68,7 @@ class MultiplexDBG
     [[nodiscard]] std::unordered_map<IndexType, bool>
     AreSeqsCanonical(const std::unordered_map<IndexType, Sequence> &seqs) const;
 
-    void ExportToGFA(
-        const std::experimental::filesystem::path &path,
-        const std::unordered_map<RRVertexType, Sequence> &vertex_seqs,
+    [[nodiscard]] GFAGraph GetGFA(
         const std::unordered_map<RREdgeIndexType, Sequence> &edge_seqs,
         const std::unordered_map<RRVertexType, RRVertexType> &vertex2rc,
         const std::unordered_map<RREdgeIndexType, RREdgeIndexType> &edge2rc,
@@ -66,13 +83,14 @@ class MultiplexDBG
                const std::unordered_map<RREdgeIndexType, bool> &edge_can
     ) const;
 
-    [[nodiscard]] std::vector<Contig> ExportContigs(
+    std::vector<Contig> ExportContigs(
         const std::experimental::filesystem::path &f,
         const std::unordered_map<RRVertexType, Sequence> &vertex_seqs,
         const std::unordered_map<RREdgeIndexType, Sequence> &edge_seqs,
         const std::unordered_map<RRVertexType, RRVertexType> &vertex2rc,
         const std::unordered_map<RRVertexType, bool> &vertex_can,
-        const std::unordered_map<RREdgeIndexType, bool> &edge_can) const;
+        const std::unordered_map<RREdgeIndexType, bool> &edge_can,
+        size_t threads) const;
 
  public:
     MultiplexDBG(const std::vector<SuccinctEdgeInfo> &edges, uint64_t start_k,
@@ -163,7 +181,9 @@ class MultiplexDBG
     [[nodiscard]] std::vector<Contig>
     GetContigs(size_t threads) const;
 
-    [[nodiscard]] std::vector<Contig>
+    // Exports contigs and returns the graph in GFA form. GFA file is written
+    // only if gfa_fn is not empty.
+    GFAGraph
     ExportContigsAndGFA(const std::experimental::filesystem::path &contigs_fn,
                         const std::experimental::filesystem::path &gfa_fn, size_t threads) const;
 
@@ -43,6 +43,7 @@ class RepeatResolver {
                    uint64_t unique_threshold,
                    bool diploid,
                    bool debug,
+                   size_t threads,
                    logging::Logger &logger)
         : dbg{dbg}, reads_storage{std::move(reads_storage)},
           extra_storages{std::move(extra_storages)}, start_k{start_k},
@@ -50,14 +51,15 @@ class RepeatResolver {
           unique_threshold{unique_threshold}, diploid{diploid}, debug{debug},
           classificator{dbg, *(this->reads_storage), diploid, debug} {
         std::experimental::filesystem::create_directory(this->dir);
-        classificator.classify(logger, unique_threshold, dir/"mult_dir");
+        classificator.classify(logger, threads, unique_threshold, dir/"mult_dir");
         // TODO reactivate filtering
 //        for (RecordStorage *const storage : get_storages()) {
 //            storage->invalidateSubreads(logger, 1);
 //        }
     }
 
-    void ResolveRepeats(logging::Logger &logger, size_t threads) {
+    // Returns the resolved graph. GFA file of the graph is written only with save_gfa.
+    GFAGraph ResolveRepeats(logging::Logger &logger, size_t threads, bool save_gfa = true) {
         logger.info() << "Resolving repeats" << std::endl;
         logger.info() << "Constructing paths" << std::endl;
         RRPaths rr_paths = PathsBuilder::FromDBGStorages(dbg, get_storages());
@@ -85,9 +87,12 @@ class RepeatResolver {
         logger.info() << "Export to Dot" << std::endl;
         mdbg.ExportToDot(dir/"mdbg.hpc.dot");
         logger.info() << "Export to GFA and compressed contigs" << std::endl;
-        std::vector<Contig> contigs = mdbg.ExportContigsAndGFA(
-            dir/"assembly.hpc.fasta", dir/"mdbg.hpc.gfa", threads);
+        GFAGraph gfa = mdbg.ExportContigsAndGFA(
+            dir/"assembly.hpc.fasta",
+            save_gfa ? dir/"mdbg.hpc.gfa" : std::experimental::filesystem::path(),
+            threads);
         logger.info() << "Finished repeat resolution" << std::endl;
+        return gfa;
     }
 };
 
@@ -115,11 +115,18 @@ namespace logging {
         Logger *empty_logger = nullptr;
         LogLevel curlevel;
         bool add_cout;
+        std::string *buffer = nullptr;
     public:
         explicit Logger(bool _add_cout = true) :
                     std::ostream(this), curlevel(LogLevel::trace), add_cout(_add_cout) {
         }
 
+        //Logger that stores messages of all levels in a string instead of printing them and takes time from parent.
+        //Used by parallel tasks so that their messages can be appended to the main log in a fixed order.
+        Logger(const Logger &parent, std::string &_buffer) :
+                    std::ostream(this), time(parent.time), curlevel(LogLevel::trace), add_cout(false), buffer(&_buffer) {
+        }
+
         Logger(const Logger &) = delete;
 
         void addLogFile(const std::experimental::filesystem::path &fn, LogLevel level = LogLevel::trace) {
@@ -136,6 +143,10 @@ namespace logging {
     //    }
 
         int overflow(int c) override {
+            if(buffer != nullptr) {
+                buffer->push_back(char(c));
+                return 0;
+            }
             if(curlevel <= LogLevel::info)
                 std::cout << char(c);
             for(LogStream &os : oss) {
@@ -176,6 +187,13 @@ namespace logging {
             return *this;
         }
 
+        //Appends messages collected by a buffered logger at trace level
+        Logger & append(const std::string &messages) {
+            curlevel = LogLevel::trace;
+            *this << messages;
+            return *this;
+        }
+
         Logger & debug() {
             curlevel = LogLevel::debug;
             *this << time.get() << " DEBUG: ";
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "verify.hpp"
+#include <omp.h>
+#include <algorithm>
+#include <queue>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Process wide memory budget. Parallel primitives ask for a portion of it to size their buffers. Without a budget
+ * every primitive keeps its default buffer sizes. Records that do not fit into the budget are spilled by the
+ * disk bucket paths of de Bruijn graph construction rather than here.
+ * The budget is set once in main and is inherited by forked stages.
+ */
+namespace memory_budget {
+    struct Budget {
+        size_t limit = 0;
+    };
+
+    inline Budget &Global() {
+        static Budget budget;
+        return budget;
+    }
+
+    inline void Set(size_t limit) {
+        Global().limit = limit;
+    }
+
+    inline bool Enabled() {
+        return Global().limit != 0;
+    }
+
+    //Returns default_value if no budget is set and at most 1/parts of the budget otherwise
+    inline size_t Portion(size_t parts, size_t default_value) {
+        if(!Enabled())
+            return default_value;
+        return std::min(default_value, Global().limit / parts);
+    }
+
+    //Only plain numbers, hashes and pointers are compacted by collectors since they are cheap to sort and compare
+    template<class T>
+    struct IsSortable : std::integral_constant<bool, std::is_scalar<T>::value ||
+                                                     std::is_same<T, unsigned __int128>::value> {};
+
+    //Merges sorted spans into a single sorted vector without duplicates.
+    //Value range is cut into parts by splitters sampled from all spans, and parts are merged by different threads
+    //through a heap over all spans.
+    template<class T>
+    std::vector<T> MergeUnique(const std::vector<std::pair<const T *, size_t>> &spans, size_t threads) {
+        const size_t samples_per_run = 64;
+        std::vector<T> samples;
+        for(const std::pair<const T *, size_t> &span : spans) {
+            for(size_t i = 1; span.second > 0 && i <= samples_per_run; i++)
+                samples.emplace_back(span.first[span.second * i / (samples_per_run + 1)]);
+        }
+        std::sort(samples.begin(), samples.end());
+        std::vector<T> splitters;
+        size_t parts = std::min(threads * 8, samples.size() + 1);
+        for(size_t i = 1; i < parts; i++) {
+            splitters.emplace_back(samples[samples.size() * i / parts]);
+        }
+        splitters.erase(std::unique(splitters.begin(), splitters.end()), splitters.end());
+        parts = splitters.size() + 1;
+        std::vector<std::vector<size_t>> bounds;
+        for(const std::pair<const T *, size_t> &span : spans) {
+            std::vector<size_t> span_bounds = {0};
+            for(const T &splitter : splitters)
+                span_bounds.emplace_back(std::lower_bound(span.first, span.first + span.second, splitter) - span.first);
+            span_bounds.emplace_back(span.second);
+            bounds.emplace_back(std::move(span_bounds));
+        }
+        std::vector<std::vector<T>> results(parts);
+        omp_set_num_threads(threads);
+#pragma omp parallel for default(none) shared(spans, bounds, results, parts) schedule(dynamic, 1)
+        for(size_t part = 0; part < parts; part++) {
+            std::vector<size_t> positions(spans.size());
+            typedef std::pair<T, size_t> Head;
+            std::priority_queue<Head, std::vector<Head>, std::greater<Head>> queue;
+            for(size_t i = 0; i < spans.size(); i++) {
+                positions[i] = bounds[i][part];
+                if(positions[i] < bounds[i][part + 1])
+                    queue.emplace(spans[i].first[positions[i]], i);
+            }
+            std::vector<T> &res = results[part];
+            while(!queue.empty()) {
+                Head head = queue.top();
+                queue.pop();
+                if(res.empty() || res.back() < head.first)
+                    res.emplace_back(head.first);
+                size_t source = head.second;
+                positions[source]++;
+                if(positions[source] < bounds[source][part + 1])
+                    queue.emplace(spans[source].first[positions[source]], source);
+            }
+        }
+        std::vector<size_t> offsets(parts + 1, 0);
+        for(size_t part = 0; part < parts; part++) {
+            offsets[part + 1] = offsets[part] + results[part].size();
+        }
+        std::vector<T> res(offsets[parts]);
+#pragma omp parallel for default(none) shared(results, offsets, res, parts) schedule(dynamic, 1)
+        for(size_t part = 0; part < parts; part++) {
+            std::copy(results[part].begin(), results[part].end(), res.begin() + offsets[part]);
+            std::vector<T>().swap(results[part]);
+        }
+        return std::move(res);
+    }
+}
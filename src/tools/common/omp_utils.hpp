@@ -3,8 +3,10 @@
 //
 #pragma once
 #include "logging.hpp"
+#include "memory_budget.hpp"
 #include <parallel/algorithm>
 #include <omp.h>
+#include <functional>
 #include <utility>
 #include <numeric>
 #include <wait.h>
@@ -33,9 +35,91 @@ public:
 
 typedef UniversalParallelCounter<size_t> ParallelCounter;
 
+//Storage modes of ParallelRecordCollector.
+//Plain: records of every thread are kept in memory in the order they were added.
+//Unique: every thread periodically sorts and deduplicates new records and merges the resulting runs with earlier ones
+//when they have similar size, so duplicates are dropped long before collectUnique. collectUnique merges runs of all
+//threads with a parallel k-way merge instead of sorting everything.
+//Unique mode is used only for plain numbers, hashes and pointers, other records are kept as in Plain mode.
+enum class CollectorMode {Plain, Unique};
+
+//Collects records produced by different threads. In Unique mode duplicates added by the same thread may be dropped
+//before collection.
 template<class T>
 class ParallelRecordCollector {
     std::vector<std::vector<T>> recs;
+    //Ends of sorted runs at the start of every row in Unique mode. Records after the last run are not compacted yet.
+    std::vector<std::vector<size_t>> run_ends;
+    CollectorMode mode;
+    size_t compaction_size = 1 << 16;
+
+    size_t tailStart(size_t thread) const {
+        return run_ends[thread].empty() ? 0 : run_ends[thread].back();
+    }
+
+    //Sorts and deduplicates records added after the last compaction. Runs are merged while the last run is at least
+    //half as long as the previous one, or until a single run is left if all is true.
+    void compact(size_t thread, bool all) {
+        std::vector<T> &row = recs[thread];
+        std::vector<size_t> &ends = run_ends[thread];
+        size_t start = tailStart(thread);
+        std::sort(row.begin() + start, row.end());
+        row.erase(std::unique(row.begin() + start, row.end()), row.end());
+        if(row.size() > start)
+            ends.emplace_back(row.size());
+        while(ends.size() >= 2) {
+            size_t right = ends[ends.size() - 2];
+            size_t left = ends.size() >= 3 ? ends[ends.size() - 3] : 0;
+            if(!all && right - left > 2 * (row.size() - right))
+                break;
+            std::inplace_merge(row.begin() + left, row.begin() + right, row.end());
+            row.erase(std::unique(row.begin() + left, row.end()), row.end());
+            ends.pop_back();
+            ends.back() = row.size();
+        }
+    }
+
+    void afterAdd() {
+        if(mode == CollectorMode::Unique)
+            compactTail(memory_budget::IsSortable<T>());
+    }
+
+    //Only collectors of sortable records leave Plain mode
+    void compactTail(std::false_type) {
+    }
+
+    void compactTail(std::true_type) {
+        size_t thread = omp_get_thread_num();
+        if(recs[thread].size() - tailStart(thread) >= compaction_size)
+            compact(thread, false);
+    }
+
+    std::vector<T> mergeUnique(std::false_type) {
+        VERIFY(false);
+        return {};
+    }
+
+    std::vector<T> mergeUnique(std::true_type) {
+        ParallelRecordCollector<T> &self = *this;
+        omp_set_num_threads(recs.size());
+#pragma omp parallel for default(none) shared(self) schedule(dynamic, 1)
+        for(size_t i = 0; i < self.recs.size(); i++) {
+            self.compact(i, false);
+        }
+        std::vector<std::pair<const T *, size_t>> spans;
+        for(size_t i = 0; i < recs.size(); i++) {
+            size_t start = 0;
+            for(size_t end : run_ends[i]) {
+                spans.emplace_back(recs[i].data() + start, end - start);
+                start = end;
+            }
+            if(start < recs[i].size())
+                spans.emplace_back(recs[i].data() + start, recs[i].size() - start);
+        }
+        std::vector<T> res = memory_budget::MergeUnique(spans, recs.size());
+        clear();
+        return std::move(res);
+    }
 public:
     friend class Iterator;
     class Iterator : public std::iterator<std::forward_iterator_tag, T, size_t,  T*, T&>{
@@ -71,21 +155,29 @@ public:
         }
 
     };
-    explicit ParallelRecordCollector(size_t thread_num) : recs(thread_num){
+    explicit ParallelRecordCollector(size_t thread_num, CollectorMode mode = CollectorMode::Plain) :
+                recs(thread_num), run_ends(thread_num),
+                mode(memory_budget::IsSortable<T>::value ? mode : CollectorMode::Plain) {
     }
 
+    ParallelRecordCollector(const ParallelRecordCollector &) = delete;
+    ParallelRecordCollector &operator=(const ParallelRecordCollector &) = delete;
+
     void add(const T &rec) {
         recs[omp_get_thread_num()].emplace_back(rec);
+        afterAdd();
     }
 
     template<class I>
     void addAll(I begin, I end) {
         recs[omp_get_thread_num()].insert(recs[omp_get_thread_num()].end(), begin, end);
+        afterAdd();
     }
 
     template< class... Args >
     void emplace_back( Args&&... args ) {
         recs[omp_get_thread_num()].emplace_back(args...);
+        afterAdd();
     }
 
     Iterator begin() {
@@ -115,6 +207,9 @@ public:
                 res.emplace_back(std::move(val));
             row.clear();
         }
+        for(std::vector<size_t> &ends : run_ends) {
+            ends.clear();
+        }
         return std::move(res);
     }
 
@@ -122,9 +217,15 @@ public:
         for(std::vector<T> &row : recs) {
             row.clear();
         }
+        for(std::vector<size_t> &ends : run_ends) {
+            ends.clear();
+        }
     }
 
+    //In Unique mode sorted runs of all threads are merged, so that only distinct records are copied
     std::vector<T> collectUnique() {
+        if(mode != CollectorMode::Plain)
+            return mergeUnique(memory_budget::IsSortable<T>());
         std::vector<T> res = collect();
         __gnu_parallel::sort(res.begin(), res.end());
         res.erase(std::unique(res.begin(), res.end()), res.end());
@@ -175,7 +276,7 @@ public:
         };
 //        size_t bucket_length = 1024 * 1024;
         size_t buffer_size = 1024 * 1024;
-        size_t max_length = 1024 * 1024 * 1024;
+        size_t max_length = memory_budget::Portion(8, 1024 * 1024 * 1024);
         ParallelProcessor<V> &self = *this;
         size_t total = 0;
         size_t total_len = 0;
@@ -274,6 +375,47 @@ public:
 
 };
 
+//Runs task for all indices in [0, n). Consecutive indices are grouped into small grains of similar total cost.
+//Grains are handed out to threads one at a time starting from the most expensive ones, so that a few costly items
+//(e.g. ultra-long reads) do not end up at the end of the queue processed by a single thread.
+//Cost of an item only needs to be proportional to its expected processing time.
+inline void processByCost(size_t threads, size_t n, const std::function<size_t(size_t)> &cost,
+                          const std::function<void(size_t)> &task, size_t grains_per_thread = 64) {
+    std::vector<size_t> costs(n);
+    omp_set_num_threads(threads);
+#pragma omp parallel for default(none) schedule(static) shared(n, costs, cost)
+    for(size_t i = 0; i < n; i++) {
+        costs[i] = cost(i) + 1;
+    }
+    size_t total = std::accumulate(costs.begin(), costs.end(), size_t(0));
+    size_t grain_cost = std::max<size_t>(1, total / std::max<size_t>(1, threads * grains_per_thread));
+    std::vector<std::pair<size_t, size_t>> grains;
+    std::vector<size_t> grain_costs;
+    size_t left = 0;
+    size_t cur_cost = 0;
+    for(size_t i = 0; i < n; i++) {
+        cur_cost += costs[i];
+        if(cur_cost >= grain_cost || i + 1 == n) {
+            grains.emplace_back(left, i + 1);
+            grain_costs.emplace_back(cur_cost);
+            left = i + 1;
+            cur_cost = 0;
+        }
+    }
+    std::vector<size_t> order(grains.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&grain_costs](size_t a, size_t b) {
+        return grain_costs[a] > grain_costs[b];
+    });
+#pragma omp parallel for default(none) schedule(dynamic, 1) shared(order, grains, task)
+    for(size_t i = 0; i < order.size(); i++) {
+        const std::pair<size_t, size_t> &grain = grains[order[i]];
+        for(size_t j = grain.first; j < grain.second; j++) {
+            task(j);
+        }
+    }
+}
+
 //This method expects that iterators return references to objects instead of temporary objects.
 template<class I>
 void processObjects(I begin, I end, logging::Logger &logger, size_t threads, std::function<void(size_t, typename I::value_type &)> task,
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <omp.h>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//Formats items with indices [0, n) in parallel and writes the result to the stream in the order of indices.
+//Consecutive items are grouped into chunks of approximately max_chunk_size bytes according to size estimates.
+//Chunks are formatted by all threads into separate buffers and then written with large sequential writes.
+//Only a batch of chunks proportional to the number of threads is kept in memory at any time.
+//The thread count only applies to this call and does not change the number of threads used by later parallel regions.
+inline void ParallelPrint(std::ostream &os, size_t n, size_t threads,
+                          const std::function<void(size_t, std::string &)> &format,
+                          const std::function<size_t(size_t)> &estimate,
+                          size_t max_chunk_size = 1 << 22) {
+    size_t batch_chunks = threads * 4;
+    std::vector<std::pair<size_t, size_t>> chunks;
+    std::vector<std::string> buffers(batch_chunks);
+    size_t pos = 0;
+    while(pos < n) {
+        chunks.clear();
+        while(pos < n && chunks.size() < batch_chunks) {
+            size_t left = pos;
+            size_t chunk_size = 0;
+            while(pos < n && (pos == left || chunk_size + estimate(pos) <= max_chunk_size)) {
+                chunk_size += estimate(pos);
+                pos++;
+            }
+            chunks.emplace_back(left, pos);
+        }
+#pragma omp parallel for default(none) shared(chunks, buffers, format, estimate) schedule(dynamic, 1) num_threads(threads)
+        for(size_t i = 0; i < chunks.size(); i++) {
+            std::string &buffer = buffers[i];
+            buffer.clear();
+            for(size_t j = chunks[i].first; j < chunks[i].second; j++) {
+                format(j, buffer);
+            }
+        }
+        for(size_t i = 0; i < chunks.size(); i++) {
+            os.write(buffers[i].data(), buffers[i].size());
+        }
+    }
+}
@@ -37,6 +37,10 @@ namespace hashing {
             return k;
         }
 
+        htype getBase() const {
+            return hbase;
+        }
+
         RollingHash extensionHash() const {
             return RollingHash(k + 1, hbase);
         }
@@ -27,6 +27,21 @@ struct log_<0, base> {
     const static size_t value = 0;
 };
 
+//Characters of the four nucleotides packed into a byte of Sequence data, for direct and reverse complement reading
+struct NuclDecodeTable {
+    char direct[256][4];
+    char rc[256][4];
+
+    NuclDecodeTable() {
+        for (size_t b = 0; b < 256; b++) {
+            for (size_t j = 0; j < 4; j++) {
+                direct[b][j] = "ACGT"[(b >> (j << 1u)) & 3u];
+                rc[b][j] = "TGCA"[(b >> ((3 - j) << 1u)) & 3u];
+            }
+        }
+    }
+};
+
 class Sequence {
     // Type to store Seq in Sequences
     typedef u_int64_t ST;
@@ -295,6 +310,9 @@ public:
 
     inline std::string str() const;
 
+    //Appends nucleotides to the end of the string. Four nucleotides are decoded at a time using lookup table.
+    inline void appendStr(std::string &res) const;
+
     inline std::string err() const;
 
     size_t size() const {
@@ -396,13 +414,44 @@ Sequence Sequence::operator+(const Sequence &s) const {
 
 std::string Sequence::str() const {
     VERIFY(size_ < 1000000000000ull);
-    std::string res(size_, '-');
-    for (size_t i = 0; i < size_; ++i) {
-        res[i] = nucl(this->operator[](i));
-    }
+    std::string res;
+    appendStr(res);
     return res;
 }
 
+void Sequence::appendStr(std::string &res) const {
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Sequence data is decoded byte by byte");
+    static const NuclDecodeTable table;
+    size_t pos = res.size();
+    res.resize(pos + size_);
+    char *out = &res[pos];
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data_->data());
+    if (!rtl_) {
+        size_t i = from_;
+        size_t end = from_ + size_;
+        for (; i < end && (i & 3u) != 0; i++, out++)
+            *out = table.direct[bytes[i >> 2u]][i & 3u];
+        for (; i + 4 <= end; i += 4, out += 4)
+            memcpy(out, table.direct[bytes[i >> 2u]], 4);
+        for (; i < end; i++, out++)
+            *out = table.direct[bytes[i >> 2u]][i & 3u];
+    } else {
+        size_t i = from_ + size_;
+        for (; i > from_ && (i & 3u) != 0; out++) {
+            i--;
+            *out = table.rc[bytes[i >> 2u]][3 - (i & 3u)];
+        }
+        for (; i >= from_ + 4; out += 4) {
+            i -= 4;
+            memcpy(out, table.rc[bytes[i >> 2u]], 4);
+        }
+        for (; i > from_; out++) {
+            i--;
+            *out = table.rc[bytes[i >> 2u]][3 - (i & 3u)];
+        }
+    }
+}
+
 std::string Sequence::err() const {
     std::ostringstream oss;
     oss << "{ *data=" << data_->data() <<